@@ -0,0 +1,382 @@
+#include "AssetCooker.h"
+#include "AssetPack.h"
+#include "ContentHash.h"
+#include "MeshCache.h"
+#include "MeshCooker.h"
+#include "Structures.h"
+#include "TextureCooker.h"
+#include "ThreadPool.h"
+#include "Debug.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    const std::string MANIFEST_PATH = ".cookmanifest";
+
+    /// <summary>
+    /// Header the compiled shaders are embedded in, included by the app's PipelineManager
+    /// </summary>
+    const std::string EMBEDDED_SHADERS_PATH = "EmbeddedShaders.h";
+
+    /// <summary>
+    /// Directories searched for sources, relative to the working directory
+    /// </summary>
+    const std::vector<std::string> SOURCE_DIRECTORIES = { "models", "textures", "shaders" };
+
+    enum class CookResult {
+        UpToDate,
+        Cooked,
+        Failed,
+
+        /// <summary>
+        /// A shader while glslc can't be run, its checked-in or previously compiled SPIR-V is kept and it is compiled once glslc is found
+        /// </summary>
+        Skipped
+    };
+
+    /// <summary>
+    /// Writes to a temporary file first so a failed write never leaves a partial file for the app to load
+    /// </summary>
+    bool writeFile(const std::string& path, const std::vector<char>& data) {
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open() || !file.write(data.data(), data.size())) return false;
+        }
+
+        std::error_code renameError;
+        std::filesystem::rename(tempPath, path, renameError);
+        return !renameError;
+    }
+
+    bool readFile(const std::string& path, std::vector<char>& data) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) return false;
+
+        data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        return static_cast<bool>(file.read(data.data(), data.size()));
+    }
+
+    /// <summary>
+    /// Turns a path into a C++ identifier, such as shaders/vert.spv into shaders_vert_spv
+    /// </summary>
+    std::string getIdentifier(const std::string& path) {
+        std::string identifier = path;
+        std::replace_if(identifier.begin(), identifier.end(), [](unsigned char c) { return !std::isalnum(c); }, '_');
+        if (identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier[0]))) identifier.insert(0, "_");
+        return identifier;
+    }
+
+    /// <summary>
+    /// The given glslc if it exists, such as the one in the SDK the app's project builds against,
+    /// then glslc from the Vulkan SDK if VULKAN_SDK is set, otherwise whichever is on the path
+    /// </summary>
+    std::string findGlslc(const std::string& preferredPath) {
+        std::error_code error;
+        if (!preferredPath.empty() && std::filesystem::is_regular_file(preferredPath, error)) return preferredPath;
+
+        const char* sdkPath = std::getenv("VULKAN_SDK");
+        if (!sdkPath) return "glslc";
+
+#ifdef _WIN32
+        return (std::filesystem::path(sdkPath) / "Bin" / "glslc.exe").string();
+#else
+        return (std::filesystem::path(sdkPath) / "bin" / "glslc").string();
+#endif
+    }
+
+    /// <summary>
+    /// Whether glslc runs at all, so a machine without the Vulkan SDK can still build with the checked-in SPIR-V
+    /// </summary>
+    bool isGlslcAvailable(const std::string& glslcPath) {
+#ifdef _WIN32
+        // cmd strips the first and last quote of a command that starts with one, so wrap it in another pair
+        const std::string command = "\"\"" + glslcPath + "\" --version >nul 2>&1\"";
+#else
+        const std::string command = "\"" + glslcPath + "\" --version >/dev/null 2>&1";
+#endif
+        return std::system(command.c_str()) == 0;
+    }
+}
+
+AssetCooker::AssetCooker(ThreadPool& threadPool, const std::string& glslcPath) : threadPool(threadPool), glslcPath(findGlslc(glslcPath)) {
+    readManifest();
+}
+
+bool AssetCooker::cook() {
+    std::vector<Source> sources = findSources();
+
+    const bool hasShaders = std::any_of(sources.begin(), sources.end(), [](const Source& source) { return source.type == SourceType::Shader; });
+    const bool canCompileShaders = hasShaders && isGlslcAvailable(glslcPath);
+    if (hasShaders && !canCompileShaders) {
+        Debug::log("warning: " + glslcPath + " can't be run, keeping the checked-in or previously compiled SPIR-V. Install the Vulkan SDK, set VULKAN_SDK or pass --glslc to compile them");
+    }
+
+    // each job hashes then cooks its source, so large sources start cooking as soon as they are hashed
+    std::vector<CookResult> results(sources.size());
+    threadPool.parallelFor(static_cast<uint32_t>(sources.size()), 1, [&](uint32_t i) {
+        Source& source = sources[i];
+        if (!hashFile(source.path, source.hash)) {
+            Debug::log("failed to read " + source.path);
+            results[i] = CookResult::Failed;
+            return;
+        }
+
+        auto cooked = manifest.find(source.path);
+        if (cooked != manifest.end() && cooked->second == source.hash && std::filesystem::exists(source.cookedPath)) {
+            results[i] = CookResult::UpToDate;
+            return;
+        }
+
+        if (source.type == SourceType::Shader && !canCompileShaders) {
+            if (!std::filesystem::exists(source.cookedPath)) {
+                Debug::log("warning: " + source.path + " has never been compiled, pipelines using it will fail to build");
+            }
+            results[i] = CookResult::Skipped;
+            return;
+        }
+
+        results[i] = cookSource(source) ? CookResult::Cooked : CookResult::Failed;
+    });
+
+    // sources that were removed or failed drop out of the manifest, so they are cooked again next time
+    std::unordered_map<std::string, uint64_t> cookedHashes;
+    std::vector<std::string> cookedPaths;
+    uint32_t cookedCount = 0, failedCount = 0, skippedCount = 0;
+    for (size_t i = 0; i < sources.size(); i++) {
+        cookedPaths.push_back(sources[i].cookedPath);
+        if (results[i] == CookResult::Failed) {
+            failedCount++;
+            continue;
+        }
+        if (results[i] == CookResult::Skipped) {
+            // keeps the hash it was last compiled from, so it is compiled again once glslc is found if it changed meanwhile
+            skippedCount++;
+            auto cooked = manifest.find(sources[i].path);
+            if (cooked != manifest.end()) cookedHashes[sources[i].path] = cooked->second;
+            continue;
+        }
+        if (results[i] == CookResult::Cooked) cookedCount++;
+        cookedHashes[sources[i].path] = sources[i].hash;
+    }
+    const bool sourcesRemoved = std::any_of(manifest.begin(), manifest.end(), [&](const auto& entry) { return cookedHashes.count(entry.first) == 0; });
+    manifest = std::move(cookedHashes);
+
+    Debug::log("cooked " + std::to_string(cookedCount) + ", up to date " + std::to_string(sources.size() - cookedCount - failedCount - skippedCount) +
+        ", failed " + std::to_string(failedCount) + ", skipped " + std::to_string(skippedCount));
+
+    bool succeeded = failedCount == 0;
+    if (!writeManifest()) {
+        Debug::log("failed to write " + MANIFEST_PATH);
+        succeeded = false;
+    }
+
+    // shaders that were skipped or failed to compile stay embedded as their existing SPIR-V, the same as in the pack
+    if (!writeEmbeddedShaders(sources)) {
+        Debug::log("failed to write " + EMBEDDED_SHADERS_PATH);
+        succeeded = false;
+    }
+
+    // sources that failed to cook keep their last cooked file in the pack, if they have one
+    if (cookedCount > 0 || sourcesRemoved || !std::filesystem::exists(PACK_PATH)) {
+        if (!AssetPack::write(PACK_PATH, cookedPaths, threadPool)) {
+            Debug::log("failed to write " + PACK_PATH);
+            succeeded = false;
+        }
+    }
+
+    return succeeded;
+}
+
+std::vector<AssetCooker::Source> AssetCooker::findSources() const {
+    std::vector<Source> sources;
+    for (const auto& directory : SOURCE_DIRECTORIES) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+            if (!entry.is_regular_file()) continue;
+
+            // forward slashes so the paths match those the app loads, on every platform
+            const std::filesystem::path& path = entry.path();
+            std::string extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            Source source;
+            source.path = path.generic_string();
+            if (extension == ".obj") {
+                source.type = SourceType::Mesh;
+                source.cookedPath = MeshCache::getCachePath(source.path);
+            } else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg") {
+                source.type = SourceType::Texture;
+                source.cookedPath = TextureCooker::getCookedPath(source.path);
+            } else if (extension == ".vert" || extension == ".frag" || extension == ".comp") {
+                // shaders named shader.<stage> compile to <stage>.spv, the same as compile_shaders.bat
+                source.type = SourceType::Shader;
+                const std::string stage = extension.substr(1);
+                source.cookedPath = path.stem() == "shader" ? (path.parent_path() / (stage + ".spv")).generic_string() : source.path + ".spv";
+            } else {
+                continue;
+            }
+            sources.push_back(std::move(source));
+        }
+    }
+
+    // sorted so the pack's contents are in the same order every run
+    std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.path < b.path; });
+    return sources;
+}
+
+bool AssetCooker::cookSource(const Source& source) const {
+    // a source that can't be cooked mustn't stop the others
+    try {
+        bool cooked = false;
+        switch (source.type) {
+            case SourceType::Mesh: cooked = cookMesh(source); break;
+            case SourceType::Texture: cooked = cookTexture(source); break;
+            case SourceType::Shader: cooked = cookShader(source); break;
+        }
+
+        Debug::log((cooked ? "cooked " : "failed to cook ") + source.path);
+        return cooked;
+    }
+    catch (const std::exception& e) {
+        Debug::log("failed to cook " + source.path + ": " + e.what());
+        return false;
+    }
+}
+
+bool AssetCooker::cookMesh(const Source& source) const {
+    return MeshCache::write(source.path, MeshCooker::cookObj(source.path));
+}
+
+bool AssetCooker::cookTexture(const Source& source) const {
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load(source.path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels) return false;
+
+    std::vector<char> cooked = TextureCooker::cook(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    stbi_image_free(pixels);
+
+    return writeFile(source.cookedPath, cooked);
+}
+
+bool AssetCooker::cookShader(const Source& source) const {
+    std::string command = "\"" + glslcPath + "\" \"" + source.path + "\" -o \"" + source.cookedPath + "\"";
+#ifdef _WIN32
+    // cmd strips the first and last quote of a command that starts with one, so wrap it in another pair
+    command = "\"" + command + "\"";
+#endif
+
+    return std::system(command.c_str()) == 0;
+}
+
+void AssetCooker::readManifest() {
+    std::ifstream file(MANIFEST_PATH);
+    if (!file.is_open()) return;
+
+    std::string line;
+    if (!std::getline(file, line) || line != "version " + std::to_string(COOKER_VERSION)) return;
+
+    // each line is the source's hash in hex then its path, which may hold spaces
+    while (std::getline(file, line)) {
+        const size_t separator = line.find(' ');
+        if (separator == std::string::npos) continue;
+
+        uint64_t hash;
+        std::istringstream hashStream(line.substr(0, separator));
+        if (!(hashStream >> std::hex >> hash)) continue;
+
+        manifest[line.substr(separator + 1)] = hash;
+    }
+}
+
+bool AssetCooker::writeManifest() const {
+    std::ostringstream contents;
+    contents << "version " << COOKER_VERSION << '\n';
+    for (const auto& [path, hash] : manifest) {
+        contents << std::hex << hash << ' ' << path << '\n';
+    }
+
+    const std::string text = contents.str();
+    return writeFile(MANIFEST_PATH, std::vector<char>(text.begin(), text.end()));
+}
+
+bool AssetCooker::writeEmbeddedShaders(const std::vector<Source>& sources) const {
+    std::ostringstream header;
+    header << "// generated by the AssetCooker from the compiled shaders, don't edit\n";
+    header << "#pragma once\n";
+    header << "#include <array>\n";
+    header << "#include <cstdint>\n";
+    header << "#include <span>\n";
+    header << "#include <string_view>\n\n";
+    header << "namespace EmbeddedShaders {\n";
+
+    std::vector<std::string> embeddedPaths;
+    for (const Source& source : sources) {
+        if (source.type != SourceType::Shader || !std::filesystem::exists(source.cookedPath)) continue;
+
+        std::vector<char> code;
+        if (!readFile(source.cookedPath, code) || code.empty() || code.size() % sizeof(uint32_t) != 0) return false;
+
+        // SPIR-V is a stream of 32 bit words, written out as words so the array is aligned for vkCreateShaderModule
+        header << "\tconstexpr uint32_t " << getIdentifier(source.cookedPath) << "[] = {";
+        for (size_t i = 0; i < code.size(); i += sizeof(uint32_t)) {
+            uint32_t word;
+            std::memcpy(&word, code.data() + i, sizeof(word));
+            header << (i % 32 == 0 ? "\n\t\t" : " ") << "0x" << std::hex << std::setw(8) << std::setfill('0') << word << std::dec << ",";
+        }
+        header << "\n\t};\n\n";
+
+        embeddedPaths.push_back(source.cookedPath);
+    }
+
+    header << "\tstruct EmbeddedShader {\n";
+    header << "\t\tstd::string_view path;\n";
+    header << "\t\tstd::span<const uint32_t> code;\n";
+    header << "\t};\n\n";
+
+    header << "\tconstexpr std::array<EmbeddedShader, " << embeddedPaths.size() << "> SHADERS = {{\n";
+    for (const std::string& path : embeddedPaths) {
+        header << "\t\t{ \"" << path << "\", " << getIdentifier(path) << " },\n";
+    }
+    header << "\t}};\n\n";
+
+    header << "\t/// <returns>The compiled shader at the path as the app loads it, empty if it isn't embedded</returns>\n";
+    header << "\tconstexpr std::span<const uint32_t> find(std::string_view path) {\n";
+    header << "\t\tfor (const auto& shader : SHADERS) {\n";
+    header << "\t\t\tif (shader.path == path) return shader.code;\n";
+    header << "\t\t}\n";
+    header << "\t\treturn {};\n";
+    header << "\t}\n";
+    header << "}\n";
+
+    const std::string text = header.str();
+    std::vector<char> existing;
+    if (readFile(EMBEDDED_SHADERS_PATH, existing) && std::equal(existing.begin(), existing.end(), text.begin(), text.end())) return true;
+
+    return writeFile(EMBEDDED_SHADERS_PATH, std::vector<char>(text.begin(), text.end()));
+}
+
+bool AssetCooker::hashFile(const std::string& path, uint64_t& hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    hash = ContentHash::SEED;
+    std::vector<char> buffer(1 << 20);
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        hash = ContentHash::hash(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+    }
+
+    return file.eof();
+}
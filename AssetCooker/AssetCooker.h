@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+/// <summary>
+/// Cooks the models, textures and shaders under the working directory into the processed files the app
+/// loads next to their sources, then packs them. Sources are hashed so only those that changed since the last run are cooked again,
+/// and cooking runs in parallel on the pool. Compiled shaders are also embedded in a generated header so the app can build its pipelines without reading files
+/// </summary>
+class AssetCooker {
+public:
+	/// <param name="glslcPath">glslc to compile shaders with, if it exists. Otherwise the one in VULKAN_SDK or on the path is used</param>
+	AssetCooker(ThreadPool& threadPool, const std::string& glslcPath = "");
+
+	/// <summary>
+	/// Cooks every changed source then rewrites the pack and the embedded shaders if anything changed.
+	/// Without glslc shaders are skipped with a warning rather than failing, keeping their checked-in or previously compiled SPIR-V
+	/// </summary>
+	/// <returns>False if any source failed to cook or the pack or embedded shaders couldn't be written</returns>
+	bool cook();
+
+	/// <summary>
+	/// Forgets every source's hash so the next cook cooks everything
+	/// </summary>
+	void clean() { manifest.clear(); }
+
+	/// <summary>
+	/// Increase whenever the cooking changes in a way the cooked files don't already record, cooks everything again
+	/// </summary>
+	static constexpr uint32_t COOKER_VERSION = 5;
+
+private:
+	enum class SourceType {
+		Mesh,
+		Texture,
+		Shader
+	};
+
+	struct Source {
+		std::string path;
+		std::string cookedPath;
+		SourceType type;
+		uint64_t hash = 0;
+	};
+
+private:
+	/// <summary>
+	/// Finds every source the cooker knows how to cook, with paths relative to the working directory as the app loads them
+	/// </summary>
+	std::vector<Source> findSources() const;
+
+	/// <returns>False if the source couldn't be cooked, leaving any earlier cooked file in place</returns>
+	bool cookSource(const Source& source) const;
+	bool cookMesh(const Source& source) const;
+	bool cookTexture(const Source& source) const;
+	bool cookShader(const Source& source) const;
+
+	/// <summary>
+	/// Reads the hash of each source as of when it was last cooked, empty if the manifest is missing or from another version
+	/// </summary>
+	void readManifest();
+	bool writeManifest() const;
+
+	/// <summary>
+	/// Generates the header embedding every compiled shader as constexpr arrays, see EMBEDDED_SHADERS_PATH.
+	/// It is only written if its contents changed, so the app isn't rebuilt for nothing
+	/// </summary>
+	/// <returns>False if a compiled shader couldn't be read or the header couldn't be written</returns>
+	bool writeEmbeddedShaders(const std::vector<Source>& sources) const;
+
+	/// <summary>
+	/// Hash of the file's contents, see ContentHash
+	/// </summary>
+	/// <returns>False if the file couldn't be read</returns>
+	static bool hashFile(const std::string& path, uint64_t& hash);
+
+private:
+	ThreadPool& threadPool;
+
+	/// <summary>
+	/// glslc as found when the cooker was created, see findGlslc
+	/// </summary>
+	const std::string glslcPath;
+
+	/// <summary>
+	/// Hash of each source when it was last cooked successfully, by path
+	/// </summary>
+	std::unordered_map<std::string, uint64_t> manifest;
+};
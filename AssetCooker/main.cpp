@@ -0,0 +1,39 @@
+#include "AssetCooker.h"
+#include "ThreadPool.h"
+
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// usage: AssetCooker [project directory] [--clean] [--glslc <path>]
+// cooks the assets under the project directory, or the working directory if not given. --clean cooks everything.
+// --glslc compiles shaders with the given glslc when it exists, otherwise VULKAN_SDK's or the one on the path
+int main(int argc, char** argv) {
+    try {
+        bool clean = false;
+        std::string glslcPath;
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            if (argument == "--clean") {
+                clean = true;
+            } else if (argument == "--glslc") {
+                if (++i == argc) throw std::runtime_error("--glslc needs a path");
+                glslcPath = argv[i];
+            } else {
+                // cooked paths are relative to the project directory, the same as the app loads them
+                std::filesystem::current_path(argument);
+            }
+        }
+
+        ThreadPool threadPool;
+        AssetCooker cooker(threadPool, glslcPath);
+        if (clean) cooker.clean();
+
+        return cooker.cook() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,509 @@
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "AsyncFileReader.h"
+#include "FileWatcher.h"
+#include "ThreadPool.h"
+#include "Model.h"
+#include "Buffer.h"
+#include "MeshCache.h"
+#include "TextureCooker.h"
+#include "ContentHash.h"
+#include "Structures.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <filesystem>
+#include <thread>
+
+namespace {
+    /// <summary>
+    /// Half the width of the placeholder cube, in model units
+    /// </summary>
+    constexpr float PLACEHOLDER_HALF_SIZE = 0.25f;
+
+    /// <summary>
+    /// Builds a white cube with each face counter clockwise from outside and mapped to the whole texture
+    /// </summary>
+    void createPlaceholderCube(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        // normal then two tangents whose cross product is the normal, so corners wind counter clockwise around it
+        const std::array<std::array<glm::vec3, 3>, 6> faces = {{
+            { glm::vec3( 1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1) },
+            { glm::vec3(-1, 0, 0), glm::vec3(0, 0, 1), glm::vec3(0, 1, 0) },
+            { glm::vec3( 0, 1, 0), glm::vec3(0, 0, 1), glm::vec3(1, 0, 0) },
+            { glm::vec3( 0,-1, 0), glm::vec3(1, 0, 0), glm::vec3(0, 0, 1) },
+            { glm::vec3( 0, 0, 1), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0) },
+            { glm::vec3( 0, 0,-1), glm::vec3(0, 1, 0), glm::vec3(1, 0, 0) },
+        }};
+        const std::array<glm::vec2, 4> corners = { glm::vec2(-1, -1), glm::vec2(1, -1), glm::vec2(1, 1), glm::vec2(-1, 1) };
+
+        for (const auto& [normal, tangent, bitangent] : faces) {
+            uint32_t first = static_cast<uint32_t>(vertices.size());
+            for (const auto& corner : corners) {
+                Vertex vertex{};
+                vertex.pos = (normal + tangent * corner.x + bitangent * corner.y) * PLACEHOLDER_HALF_SIZE;
+                vertex.color = { 1.0f, 1.0f, 1.0f };
+                vertex.texCoord = corner * 0.5f + 0.5f;
+                vertices.push_back(vertex);
+            }
+
+            for (uint32_t index : { 0u, 1u, 2u, 2u, 3u, 0u }) {
+                indices.push_back(first + index);
+            }
+        }
+    }
+}
+
+AssetLoader::AssetLoader(ThreadPool& threadPool, const std::unique_ptr<AssetPack>& assetPack, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool,
+                         const std::unique_ptr<GeometryBuffer>& geometryBuffer)
+    : threadPool(threadPool), assetPack(assetPack), device(device), physicalDevice(physicalDevice), graphicsPool(graphicsPool), transferPool(transferPool), geometryBuffer(geometryBuffer) {
+    fileReader = std::make_unique<AsyncFileReader>(threadPool);
+    fileWatcher = std::make_unique<FileWatcher>();
+
+    std::vector<Vertex> cubeVertices;
+    std::vector<uint32_t> cubeIndices;
+    createPlaceholderCube(cubeVertices, cubeIndices);
+    placeholderModel = std::make_unique<Model>(device, physicalDevice, cubeVertices, cubeIndices);
+    placeholderModel->upload(device, physicalDevice, graphicsPool, transferPool, geometryBuffer);
+
+    // grey checkerboard so a missing texture is obvious without being garish
+    const std::array<uint8_t, 16> checkerPixels = {
+        200, 200, 200, 255,   100, 100, 100, 255,
+        100, 100, 100, 255,   200, 200, 200, 255,
+    };
+    placeholderTexture = std::make_unique<Texture>(device, physicalDevice, graphicsPool, transferPool, Texture::stage(checkerPixels.data(), 2, 2, device, physicalDevice));
+}
+
+AssetLoader::~AssetLoader() {
+    // loads waiting to upload only continue when resumed on this thread, so keep resuming them until all have finished
+    while (std::any_of(loads.begin(), loads.end(), [](const Task<void>& load) { return !load.isDone(); })) {
+        threadPool.runMainThreadJobs();
+        std::this_thread::yield();
+    }
+}
+
+ModelHandle AssetLoader::loadModel(const std::string& path) {
+    bool created = false;
+    ModelHandle handle = acquire<Model>(path, created);
+    if (created) {
+        loads.push_back(guardLoad<Model>(handle.getIndex(), streamModel(handle.getIndex(), path)));
+        loads.back().start();
+    }
+
+    return handle;
+}
+
+TextureHandle AssetLoader::loadTexture(const std::string& path) {
+    bool created = false;
+    TextureHandle handle = acquire<Texture>(path, created);
+    if (created) {
+        loads.push_back(guardLoad<Texture>(handle.getIndex(), streamTexture(handle.getIndex(), path)));
+        loads.back().start();
+    }
+
+    return handle;
+}
+
+bool AssetLoader::update() {
+    // paths are watched for as long as they have an entry, so each changed path belongs to a model or a texture
+    for (const std::string& path : fileWatcher->takeChanged()) {
+        auto model = models.pathEntries.find(path);
+        if (model != models.pathEntries.end()) reload<Model>(model->second);
+
+        auto texture = textures.pathEntries.find(path);
+        if (texture != textures.pathEntries.end()) reload<Texture>(texture->second);
+    }
+
+    // get rethrows anything a load threw on its worker, here on the main thread
+    bool finished = false;
+    for (auto load = loads.begin(); load != loads.end();) {
+        if (!load->isDone()) {
+            load++;
+            continue;
+        }
+        load->get();
+        load = loads.erase(load);
+        finished = true;
+    }
+
+    destroyRetired<Model>();
+    destroyRetired<Texture>();
+
+    return finished;
+}
+
+Task<std::vector<char>> AssetLoader::readFile(std::string path) {
+    co_await threadPool.schedule();
+
+    if (assetPack && assetPack->contains(path)) {
+        co_return assetPack->read(path, threadPool);
+    }
+
+    // loose files are read asynchronously so many reads can be in flight without tying up the workers
+    co_return co_await fileReader->read(path);
+}
+
+Task<TextureImage> AssetLoader::decodeTexture(std::vector<char> file, bool cooked) {
+    co_await threadPool.schedule();
+    co_return cooked ? Texture::stageCooked(file, device, physicalDevice) : Texture::decode(file, device, physicalDevice);
+}
+
+Task<std::unique_ptr<Texture>> AssetLoader::uploadTexture(TextureImage decodedImage) {
+    co_await threadPool.scheduleOnMainThread();
+    co_return std::make_unique<Texture>(device, physicalDevice, graphicsPool, transferPool, decodedImage);
+}
+
+Task<std::unique_ptr<Model>> AssetLoader::stageModel(std::string path, std::vector<char> file, bool cooked) {
+    co_await threadPool.schedule();
+
+    // a packed mesh cache skips reading both the source and the cache from loose files
+    MeshCacheData cache;
+    if (cooked && MeshCache::parse(file, cache)) {
+        co_return std::make_unique<Model>(device, physicalDevice, cache);
+    }
+
+    co_return std::make_unique<Model>(device, physicalDevice, path);
+}
+
+Task<std::unique_ptr<Model>> AssetLoader::uploadModel(std::unique_ptr<Model> model) {
+    co_await threadPool.scheduleOnMainThread();
+    model->upload(device, physicalDevice, graphicsPool, transferPool, geometryBuffer);
+    co_return model;
+}
+
+Task<void> AssetLoader::streamModel(uint32_t index, std::string path) {
+    // packed models are hashed by their mesh cache and loose ones by their source, as loose caches might be out of date
+    const std::string cachePath = MeshCache::getCachePath(path);
+    const bool cooked = assetPack && assetPack->contains(cachePath);
+
+    std::unique_ptr<Model> model;
+    if (cooked) {
+        std::vector<char> file = co_await readFile(cachePath);
+        if (co_await shareContent<Model>(index, ContentHash::hash(file.data(), file.size()), file.size())) co_return;
+        model = co_await stageModel(path, std::move(file), cooked);
+    } else {
+        // the loose cache records its source's hash, or the source is hashed as it is cooked, so it is never read just to hash it.
+        // Sharing is only found out after staging, rare enough that the wasted staging costs less than a second read
+        model = co_await stageModel(path, {}, cooked);
+        if (co_await shareContent<Model>(index, model->getSourceHash(), model->getSourceSize())) co_return;
+    }
+
+    finishLoad(index, co_await uploadModel(std::move(model)));
+}
+
+Task<void> AssetLoader::streamTexture(uint32_t index, std::string path) {
+    // cooked textures skip decoding a compressed image and generating mipmaps
+    const std::string cookedPath = TextureCooker::getCookedPath(path);
+    const bool cooked = (assetPack && assetPack->contains(cookedPath)) || std::filesystem::exists(cookedPath);
+
+    std::vector<char> file = co_await readFile(cooked ? cookedPath : path);
+    if (co_await shareContent<Texture>(index, ContentHash::hash(file.data(), file.size()), file.size())) co_return;
+
+    TextureImage decodedImage = co_await decodeTexture(std::move(file), cooked);
+    finishLoad(index, co_await uploadTexture(std::move(decodedImage)));
+}
+
+Task<void> AssetLoader::reloadModel(uint32_t index, std::string path) {
+    // the model's loose cache is older than its source now, so the source is cooked again, hashed as it is read, and the cache rewritten
+    std::unique_ptr<Model> model = co_await stageModel(path, {}, false);
+    const uint64_t contentHash = model->getSourceHash();
+    const uint64_t contentSize = model->getSourceSize();
+    if (co_await swapContent<Model>(index, contentHash, contentSize)) co_return;
+
+    replaceAsset(index, contentHash, contentSize, co_await uploadModel(std::move(model)));
+}
+
+Task<void> AssetLoader::reloadTexture(uint32_t index, std::string path) {
+    co_await threadPool.schedule();
+    std::vector<char> file = co_await fileReader->read(path);
+    const uint64_t contentHash = ContentHash::hash(file.data(), file.size());
+    const uint64_t contentSize = file.size();
+    if (co_await swapContent<Texture>(index, contentHash, contentSize)) co_return;
+
+    TextureImage decodedImage = co_await decodeTexture(std::move(file), false);
+    replaceAsset(index, contentHash, contentSize, co_await uploadTexture(std::move(decodedImage)));
+}
+
+const std::unique_ptr<Model>& AssetLoader::getModel(const ModelHandle& handle) const {
+    const auto& model = getAsset<Model>(handle.getIndex());
+    return model ? model : placeholderModel;
+}
+
+const std::unique_ptr<Texture>& AssetLoader::getTexture(const TextureHandle& handle) const {
+    const auto& texture = getAsset<Texture>(handle.getIndex());
+    return texture ? texture : placeholderTexture;
+}
+
+template<typename T>
+AssetHandle<T> AssetLoader::acquire(const std::string& path, bool& created) {
+    auto& table = getTable<T>();
+    auto existing = table.pathEntries.find(path);
+    if (existing != table.pathEntries.end()) {
+        return AssetHandle<T>(this, existing->second);
+    }
+
+    uint32_t index;
+    if (!table.freeEntries.empty()) {
+        index = table.freeEntries.back();
+        table.freeEntries.pop_back();
+    } else {
+        index = static_cast<uint32_t>(table.entries.size());
+        table.entries.emplace_back();
+    }
+
+    auto& entry = table.entries[index];
+    entry.path = path;
+    entry.loading = true;
+    table.pathEntries[path] = index;
+    fileWatcher->watch(path);
+
+    created = true;
+    return AssetHandle<T>(this, index);
+}
+
+template<typename T>
+void AssetLoader::addReference(uint32_t index) {
+    getTable<T>().entries[index].refCount++;
+}
+
+template<typename T>
+void AssetLoader::release(uint32_t index) {
+    if (--getTable<T>().entries[index].refCount == 0) {
+        unload<T>(index);
+    }
+}
+
+template<typename T>
+void AssetLoader::unload(uint32_t index) {
+    auto& table = getTable<T>();
+    auto& entry = table.entries[index];
+
+    // finishLoad unloads it once it finishes, if nothing has referenced it again by then
+    if (entry.loading) return;
+
+    // frames in flight may still be drawing with the asset
+    if (entry.asset) {
+        table.retired.emplace_back(std::move(entry.asset), MAX_FRAMES_IN_FLIGHT);
+    }
+
+    table.pathEntries.erase(entry.path);
+    fileWatcher->unwatch(entry.path);
+
+    auto content = table.contentEntries.find(entry.contentHash);
+    if (entry.hasContentHash && content != table.contentEntries.end() && content->second == index) {
+        table.contentEntries.erase(content);
+    }
+
+    const uint32_t sharedEntry = entry.sharedEntry;
+    entry = AssetEntry<T>();
+    table.freeEntries.push_back(index);
+
+    if (sharedEntry != NO_ENTRY) {
+        release<T>(sharedEntry);
+    }
+}
+
+template<typename T>
+Task<bool> AssetLoader::shareContent(uint32_t index, uint64_t contentHash, uint64_t contentSize) {
+    co_await threadPool.scheduleOnMainThread();
+
+    auto& table = getTable<T>();
+    auto& entry = table.entries[index];
+
+    entry.contentHash = contentHash;
+    entry.contentSize = contentSize;
+    entry.hasContentHash = true;
+
+    auto existing = table.contentEntries.find(contentHash);
+    if (existing == table.contentEntries.end()) {
+        table.contentEntries[contentHash] = index;
+        co_return false;
+    }
+
+    // a different size with the same hash is a collision, loaded separately and left unregistered
+    if (table.entries[existing->second].contentSize != contentSize) co_return false;
+
+    // the same file under another path, so share the asset already loading or loaded rather than load it again
+    entry.sharedEntry = existing->second;
+    addReference<T>(entry.sharedEntry);
+    finishLoading<T>(index);
+    co_return true;
+}
+
+template<typename T>
+Task<void> AssetLoader::guardLoad(uint32_t index, Task<void> load) {
+    // can't await in a handler, so the failure is kept until after it
+    std::exception_ptr failure;
+    try {
+        co_await load;
+    } catch (...) {
+        failure = std::current_exception();
+    }
+    if (!failure) co_return;
+
+    co_await threadPool.scheduleOnMainThread();
+    try {
+        std::rethrow_exception(failure);
+    } catch (const std::exception& exception) {
+        Debug::log("failed to load " + getTable<T>().entries[index].path + ": " + exception.what());
+    } catch (...) {
+        Debug::log("failed to load " + getTable<T>().entries[index].path);
+    }
+    finishLoading<T>(index);
+}
+
+template<typename T>
+void AssetLoader::finishLoad(uint32_t index, std::unique_ptr<T> asset) {
+    getTable<T>().entries[index].asset = std::move(asset);
+    finishLoading<T>(index);
+}
+
+template<typename T>
+void AssetLoader::finishLoading(uint32_t index) {
+    auto& entry = getTable<T>().entries[index];
+    entry.loading = false;
+
+    // every handle was destroyed while it loaded
+    if (entry.refCount == 0) {
+        unload<T>(index);
+    } else if (entry.reloadQueued) {
+        entry.reloadQueued = false;
+        reload<T>(index);
+    }
+}
+
+template<typename T>
+void AssetLoader::reload(uint32_t index) {
+    auto& entry = getTable<T>().entries[index];
+
+    // the load in progress may have read the file before this change, so it is read again once that finishes
+    if (entry.loading) {
+        entry.reloadQueued = true;
+        return;
+    }
+
+    // handles keep drawing with the old asset until the new one is swapped in
+    entry.loading = true;
+    if constexpr (std::is_same_v<T, Model>) loads.push_back(guardLoad<Model>(index, reloadModel(index, entry.path)));
+    else loads.push_back(guardLoad<Texture>(index, reloadTexture(index, entry.path)));
+    loads.back().start();
+}
+
+template<typename T>
+void AssetLoader::detachContent(uint32_t index) {
+    auto& table = getTable<T>();
+    auto& entry = table.entries[index];
+
+    if (entry.sharedEntry != NO_ENTRY) {
+        entry.hasContentHash = false;
+        release<T>(std::exchange(entry.sharedEntry, NO_ENTRY));
+        return;
+    }
+
+    auto content = table.contentEntries.find(entry.contentHash);
+    if (!entry.hasContentHash || content == table.contentEntries.end() || content->second != index) {
+        // nothing shares an asset whose contents aren't registered
+        if (entry.asset) {
+            table.retired.emplace_back(std::move(entry.asset), MAX_FRAMES_IN_FLIGHT);
+        }
+        entry.hasContentHash = false;
+        return;
+    }
+
+    // entries sharing this one still hold the old contents, so the first becomes their owner, taking over their references
+    uint32_t heir = NO_ENTRY;
+    for (uint32_t i = 0; i < table.entries.size(); i++) {
+        auto& sharer = table.entries[i];
+        if (sharer.sharedEntry != index) continue;
+
+        entry.refCount--;
+        if (heir == NO_ENTRY) {
+            heir = i;
+            sharer.sharedEntry = NO_ENTRY;
+            sharer.asset = std::move(entry.asset);
+        } else {
+            sharer.sharedEntry = heir;
+            table.entries[heir].refCount++;
+        }
+    }
+
+    if (heir == NO_ENTRY) {
+        table.contentEntries.erase(content);
+        if (entry.asset) {
+            table.retired.emplace_back(std::move(entry.asset), MAX_FRAMES_IN_FLIGHT);
+        }
+    } else {
+        content->second = heir;
+    }
+    entry.hasContentHash = false;
+}
+
+template<typename T>
+Task<bool> AssetLoader::swapContent(uint32_t index, uint64_t contentHash, uint64_t contentSize) {
+    co_await threadPool.scheduleOnMainThread();
+
+    auto& table = getTable<T>();
+    auto& entry = table.entries[index];
+
+    // saved without changes, or changed back to the contents it already shares
+    if (entry.hasContentHash && entry.contentHash == contentHash && entry.contentSize == contentSize) {
+        finishLoading<T>(index);
+        co_return true;
+    }
+
+    auto existing = table.contentEntries.find(contentHash);
+    if (existing == table.contentEntries.end() || table.entries[existing->second].contentSize != contentSize) co_return false;
+
+    // now the same as another file, so share its asset rather than load it again
+    const uint32_t sharedEntry = existing->second;
+    detachContent<T>(index);
+    entry.sharedEntry = sharedEntry;
+    entry.contentHash = contentHash;
+    entry.contentSize = contentSize;
+    entry.hasContentHash = true;
+    addReference<T>(sharedEntry);
+    finishLoading<T>(index);
+    co_return true;
+}
+
+template<typename T>
+void AssetLoader::replaceAsset(uint32_t index, uint64_t contentHash, uint64_t contentSize, std::unique_ptr<T> asset) {
+    auto& table = getTable<T>();
+    auto& entry = table.entries[index];
+
+    detachContent<T>(index);
+    entry.asset = std::move(asset);
+    entry.contentHash = contentHash;
+    entry.contentSize = contentSize;
+    entry.hasContentHash = true;
+
+    // another entry may have loaded the same contents while this one reloaded, which keeps the registration
+    table.contentEntries.try_emplace(contentHash, index);
+    finishLoading<T>(index);
+}
+
+template<typename T>
+const std::unique_ptr<T>& AssetLoader::getAsset(uint32_t index) const {
+    const auto& table = getTable<T>();
+    const auto& entry = table.entries[index];
+    return entry.sharedEntry != NO_ENTRY ? table.entries[entry.sharedEntry].asset : entry.asset;
+}
+
+template<typename T>
+void AssetLoader::destroyRetired() {
+    auto& retired = getTable<T>().retired;
+    for (auto asset = retired.begin(); asset != retired.end();) {
+        if (--asset->second == 0) {
+            asset = retired.erase(asset);
+        } else {
+            asset++;
+        }
+    }
+}
+
+// handles reference and release their entries from outside this file
+template void AssetLoader::addReference<Model>(uint32_t index);
+template void AssetLoader::addReference<Texture>(uint32_t index);
+template void AssetLoader::release<Model>(uint32_t index);
+template void AssetLoader::release<Texture>(uint32_t index);
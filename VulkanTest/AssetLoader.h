@@ -0,0 +1,347 @@
+#pragma once
+#include "Texture.h"
+#include "Task.h"
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class AssetLoader;
+class AssetPack;
+class AsyncFileReader;
+class FileWatcher;
+class Model;
+class GeometryBuffer;
+class ThreadPool;
+
+/// <summary>
+/// Counted reference to an asset of an AssetLoader, copies share the asset and it is unloaded once the last one is destroyed.
+/// Only use on the main thread and destroy before the loader
+/// </summary>
+template<typename T>
+class AssetHandle {
+public:
+	AssetHandle() = default;
+	AssetHandle(const AssetHandle& other);
+	AssetHandle(AssetHandle&& other) noexcept;
+	AssetHandle& operator=(AssetHandle other) noexcept;
+	~AssetHandle();
+
+	/// <summary>
+	/// Drops this reference, leaving the handle empty
+	/// </summary>
+	void reset();
+
+	const bool isValid() const { return loader != nullptr; }
+	const uint32_t getIndex() const { return index; }
+
+private:
+	friend class AssetLoader;
+
+	/// <summary>
+	/// Takes a new reference to the loader's entry
+	/// </summary>
+	AssetHandle(AssetLoader* loader, uint32_t index);
+
+private:
+	AssetLoader* loader = nullptr;
+	uint32_t index = 0;
+};
+
+using ModelHandle = AssetHandle<Model>;
+using TextureHandle = AssetHandle<Texture>;
+
+/// <summary>
+/// Loads models and textures on a thread pool, handing out handles straight away. Until an asset is
+/// uploaded its handle resolves to a small placeholder, so rendering never waits on loading.
+/// Assets are shared rather than loaded twice, by path and then by a hash of their file's contents, and
+/// unloaded once their last handle is destroyed. Loaded assets whose source file changes are reloaded, redoing only
+/// that asset's decode and upload, with the new asset swapped in on a frame boundary and the old one retired.
+/// Each load is a coroutine awaiting its steps in order, the file reads and decodes resume on the pool
+/// and uploads resume on the main thread with the pool's main thread jobs, so dependent loads can be written as one sequence.
+/// A load that fails is logged and leaves its handle on the placeholder, or the asset it had before a reload
+/// </summary>
+class AssetLoader {
+public:
+	/// <param name="assetPack">Files in the pack are read from it rather than from loose files, can be null</param>
+	/// <param name="geometryBuffer">Models' vertices and indices are uploaded into it, so it must outlive the loader</param>
+	AssetLoader(ThreadPool& threadPool, const std::unique_ptr<AssetPack>& assetPack, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool,
+				const std::unique_ptr<GeometryBuffer>& geometryBuffer);
+
+	/// <summary>
+	/// Keeps running main thread jobs until every load has finished, as they write back into the loader
+	/// </summary>
+	~AssetLoader();
+
+	/// <summary>
+	/// Starts loading and processing a model into staging buffers on the pool, or shares it if it is already loaded
+	/// </summary>
+	ModelHandle loadModel(const std::string& path);
+
+	/// <summary>
+	/// Starts reading and decoding a texture into its staging buffer on the pool, preferring its cooked file if there is one,
+	/// or shares it if it is already loaded
+	/// </summary>
+	TextureHandle loadTexture(const std::string& path);
+
+	/// <summary>
+	/// Starts reloading assets whose source files changed, forgets finished loads, rethrowing anything they threw,
+	/// and destroys unloaded and replaced assets no frame in flight can still be using.
+	/// Loads swap their asset in for its placeholder when they upload in ThreadPool::runMainThreadJobs, so run those and
+	/// this on a frame boundary so a frame never sees an asset change part way through recording
+	/// </summary>
+	/// <returns>True if any load finished</returns>
+	bool update();
+
+	/// <returns>The model if it has been uploaded, otherwise the placeholder</returns>
+	const std::unique_ptr<Model>& getModel(const ModelHandle& handle) const;
+
+	/// <returns>The texture if it has been uploaded, otherwise the placeholder</returns>
+	const std::unique_ptr<Texture>& getTexture(const TextureHandle& handle) const;
+
+	const bool isLoading() const { return !loads.empty(); }
+
+	/// <summary>
+	/// Reads a whole file from the asset pack if it holds it, otherwise queues an asynchronous read of the loose file
+	/// </summary>
+	Task<std::vector<char>> readFile(std::string path);
+
+	/// <summary>
+	/// Decodes an image file into a staging buffer on the pool
+	/// </summary>
+	/// <param name="cooked">The file was cooked by the AssetCooker so already has its mip chain and only needs copying</param>
+	Task<TextureImage> decodeTexture(std::vector<char> file, bool cooked);
+
+	/// <summary>
+	/// Copies a decoded image to a device local texture on the main thread
+	/// </summary>
+	Task<std::unique_ptr<Texture>> uploadTexture(TextureImage decodedImage);
+
+	/// <summary>
+	/// Stages a model into staging buffers on the pool
+	/// </summary>
+	/// <param name="file">The model's packed mesh cache if cooked, otherwise unused as loose models load through their own cache,
+	/// which records the source's size and hash so the source is read at most once</param>
+	Task<std::unique_ptr<Model>> stageModel(std::string path, std::vector<char> file, bool cooked);
+
+	/// <summary>
+	/// Copies a staged model to device local buffers on the main thread
+	/// </summary>
+	Task<std::unique_ptr<Model>> uploadModel(std::unique_ptr<Model> model);
+
+private:
+	template<typename T>
+	friend class AssetHandle;
+
+	static constexpr uint32_t NO_ENTRY = ~0u;
+
+	template<typename T>
+	struct AssetEntry {
+		std::string path;
+
+		/// <summary>
+		/// Null until uploaded, and always for entries sharing another's asset
+		/// </summary>
+		std::unique_ptr<T> asset;
+		uint32_t refCount = 0;
+		bool loading = false;
+
+		/// <summary>
+		/// The source changed again while loading, so it is reloaded once that finishes
+		/// </summary>
+		bool reloadQueued = false;
+
+		/// <summary>
+		/// Entry that loaded the same contents first, which this entry holds a reference to and shares the asset of
+		/// </summary>
+		uint32_t sharedEntry = NO_ENTRY;
+
+		/// <summary>
+		/// Hash of the file contents, only registered in contentEntries for entries that load their own asset.
+		/// Contents are only shared when their sizes match too, so a hash collision loads its own asset
+		/// </summary>
+		uint64_t contentHash = 0;
+		uint64_t contentSize = 0;
+		bool hasContentHash = false;
+	};
+
+	template<typename T>
+	struct AssetTable {
+		std::vector<AssetEntry<T>> entries;
+		std::vector<uint32_t> freeEntries;
+		std::unordered_map<std::string, uint32_t> pathEntries;
+		std::unordered_map<uint64_t, uint32_t> contentEntries;
+
+		/// <summary>
+		/// Unloaded and replaced assets and how many more frame boundaries until no frame in flight can be using them
+		/// </summary>
+		std::vector<std::pair<std::unique_ptr<T>, uint32_t>> retired;
+	};
+
+private:
+	template<typename T>
+	AssetTable<T>& getTable() {
+		if constexpr (std::is_same_v<T, Model>) return models;
+		else return textures;
+	}
+
+	template<typename T>
+	const AssetTable<T>& getTable() const {
+		return const_cast<AssetLoader*>(this)->getTable<T>();
+	}
+
+	/// <summary>
+	/// Finds the entry already loaded from the path, otherwise adds one to be loaded
+	/// </summary>
+	/// <param name="created">Set if the entry was added, so its load needs starting</param>
+	template<typename T>
+	AssetHandle<T> acquire(const std::string& path, bool& created);
+
+	template<typename T>
+	void addReference(uint32_t index);
+
+	/// <summary>
+	/// Unloads the entry once its last reference is released
+	/// </summary>
+	template<typename T>
+	void release(uint32_t index);
+
+	/// <summary>
+	/// Retires the entry's asset and frees the entry, waiting for it to finish loading first
+	/// </summary>
+	template<typename T>
+	void unload(uint32_t index);
+
+	/// <summary>
+	/// Looks up the contents on the main thread. If another entry already loaded them this entry shares its asset,
+	/// otherwise the contents are registered to this entry so later loads can share with it
+	/// </summary>
+	/// <returns>True if the entry now shares another's asset and doesn't need loading</returns>
+	template<typename T>
+	Task<bool> shareContent(uint32_t index, uint64_t contentHash, uint64_t contentSize);
+
+	/// <summary>
+	/// Swaps the uploaded asset in for the placeholder, call on the main thread
+	/// </summary>
+	template<typename T>
+	void finishLoad(uint32_t index, std::unique_ptr<T> asset);
+
+	/// <summary>
+	/// Runs one of the entry's loads. If it throws, logs why on the main thread and marks the entry loaded,
+	/// keeping the placeholder or its previous asset so a broken source can be fixed and reloaded
+	/// </summary>
+	template<typename T>
+	Task<void> guardLoad(uint32_t index, Task<void> load);
+
+	/// <summary>
+	/// Marks the entry loaded, then unloads it if every handle was destroyed meanwhile or reloads it if its source changed again
+	/// </summary>
+	template<typename T>
+	void finishLoading(uint32_t index);
+
+	/// <summary>
+	/// Starts reloading the entry from its source file, or queues it if the entry is still loading
+	/// </summary>
+	template<typename T>
+	void reload(uint32_t index);
+
+	/// <summary>
+	/// Stops the entry sharing its asset or its contents, before it takes new contents. Entries sharing this
+	/// entry's asset keep the old one, handed over to the first of them along with the contents' registration
+	/// </summary>
+	template<typename T>
+	void detachContent(uint32_t index);
+
+	/// <summary>
+	/// Gives the entry its reloaded contents on the main thread, sharing them if another entry already has them
+	/// </summary>
+	/// <returns>True if the entry now shares another's asset or the contents are unchanged, so it doesn't need loading</returns>
+	template<typename T>
+	Task<bool> swapContent(uint32_t index, uint64_t contentHash, uint64_t contentSize);
+
+	/// <summary>
+	/// Swaps the reloaded asset in for the old one, which is retired, call on the main thread
+	/// </summary>
+	template<typename T>
+	void replaceAsset(uint32_t index, uint64_t contentHash, uint64_t contentSize, std::unique_ptr<T> asset);
+
+	/// <summary>
+	/// The entry's own asset or the one it shares, null until uploaded
+	/// </summary>
+	template<typename T>
+	const std::unique_ptr<T>& getAsset(uint32_t index) const;
+
+	/// <summary>
+	/// Destroys retired assets once every frame that could have drawn with them has finished
+	/// </summary>
+	template<typename T>
+	void destroyRetired();
+
+	Task<void> streamModel(uint32_t index, std::string path);
+	Task<void> streamTexture(uint32_t index, std::string path);
+
+	/// <summary>
+	/// Reloads from the loose source file, as the cooked files and the pack are out of date until the AssetCooker runs again
+	/// </summary>
+	Task<void> reloadModel(uint32_t index, std::string path);
+	Task<void> reloadTexture(uint32_t index, std::string path);
+
+private:
+	ThreadPool& threadPool;
+	const std::unique_ptr<AssetPack>& assetPack;
+	std::unique_ptr<AsyncFileReader> fileReader;
+	std::unique_ptr<FileWatcher> fileWatcher;
+	const std::unique_ptr<LogicalDevice>& device;
+	const std::unique_ptr<PhysicalDevice>& physicalDevice;
+	const std::unique_ptr<CommandPool>& graphicsPool;
+	const std::unique_ptr<CommandPool>& transferPool;
+	const std::unique_ptr<GeometryBuffer>& geometryBuffer;
+
+	std::unique_ptr<Model> placeholderModel;
+	std::unique_ptr<Texture> placeholderTexture;
+
+	/// <summary>
+	/// Loaded assets by handle index, only used on the main thread
+	/// </summary>
+	AssetTable<Model> models;
+	AssetTable<Texture> textures;
+
+	/// <summary>
+	/// Started loads, kept until update sees them finish
+	/// </summary>
+	std::vector<Task<void>> loads;
+};
+
+template<typename T>
+AssetHandle<T>::AssetHandle(AssetLoader* loader, uint32_t index) : loader(loader), index(index) {
+	loader->addReference<T>(index);
+}
+
+template<typename T>
+AssetHandle<T>::AssetHandle(const AssetHandle& other) : loader(other.loader), index(other.index) {
+	if (loader) loader->addReference<T>(index);
+}
+
+template<typename T>
+AssetHandle<T>::AssetHandle(AssetHandle&& other) noexcept : loader(std::exchange(other.loader, nullptr)), index(other.index) { }
+
+template<typename T>
+AssetHandle<T>& AssetHandle<T>::operator=(AssetHandle other) noexcept {
+	std::swap(loader, other.loader);
+	std::swap(index, other.index);
+	return *this;
+}
+
+template<typename T>
+AssetHandle<T>::~AssetHandle() {
+	reset();
+}
+
+template<typename T>
+void AssetHandle<T>::reset() {
+	if (loader) loader->release<T>(std::exchange(index, 0));
+	loader = nullptr;
+}
+
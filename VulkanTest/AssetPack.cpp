@@ -0,0 +1,419 @@
+#include "AssetPack.h"
+#include "ThreadPool.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr uint32_t PACK_MAGIC = 0x4B415056; // "VPAK"
+
+    /// <summary>
+    /// Increase whenever the file layout or the compression changes
+    /// </summary>
+    constexpr uint32_t PACK_VERSION = 1;
+
+    /// <summary>
+    /// Chunks are stored first, then the table of contents so it can be written once every chunk's offset is known
+    /// </summary>
+    struct PackHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t chunkCount;
+        uint64_t tocOffset;
+        uint64_t tocSize;
+    };
+
+    // LZ4 block format, every chunk is a block of sequences each made of a run of literals then a match
+    constexpr uint32_t MIN_MATCH = 4;
+    constexpr uint32_t MAX_OFFSET = 65535;
+
+    /// <summary>
+    /// The last bytes of a block are always literals and the last match must start this far before the end
+    /// </summary>
+    constexpr size_t LAST_LITERALS = 5;
+    constexpr size_t MATCH_FIND_LIMIT = 12;
+
+    constexpr uint32_t HASH_BITS = 16;
+
+    inline uint32_t load32(const uint8_t* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t hashSequence(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    /// <summary>
+    /// Lengths over 15 spill into bytes after the token, 255 meaning another byte follows
+    /// </summary>
+    void appendLength(std::vector<uint8_t>& out, size_t length) {
+        for (; length >= 255; length -= 255) {
+            out.push_back(255);
+        }
+        out.push_back(static_cast<uint8_t>(length));
+    }
+
+    void appendSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, uint32_t offset, size_t matchLength) {
+        const size_t matchCode = matchLength - MIN_MATCH;
+        out.push_back(static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+        if (literalCount >= 15) appendLength(out, literalCount - 15);
+        out.insert(out.end(), literals, literals + literalCount);
+
+        out.push_back(static_cast<uint8_t>(offset & 0xff));
+        out.push_back(static_cast<uint8_t>(offset >> 8));
+        if (matchCode >= 15) appendLength(out, matchCode - 15);
+    }
+
+    /// <summary>
+    /// Greedy single probe hash matching, skipping ahead faster the longer it goes without a match
+    /// </summary>
+    std::vector<uint8_t> compressChunk(const uint8_t* input, size_t size) {
+        std::vector<uint8_t> out;
+        out.reserve(size + size / 255 + 16);
+
+        // positions are stored plus one so zero means empty
+        std::vector<uint32_t> table(1u << HASH_BITS, 0);
+
+        size_t anchor = 0;
+        size_t position = 0;
+        if (size > MATCH_FIND_LIMIT) {
+            const size_t matchStartLimit = size - MATCH_FIND_LIMIT;
+            const size_t matchEndLimit = size - LAST_LITERALS;
+
+            while (position < matchStartLimit) {
+                const uint32_t sequence = load32(input + position);
+                const uint32_t hash = hashSequence(sequence);
+                const size_t candidate = table[hash];
+                table[hash] = static_cast<uint32_t>(position + 1);
+
+                if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || load32(input + candidate - 1) != sequence) {
+                    position += 1 + ((position - anchor) >> 6);
+                    continue;
+                }
+
+                size_t match = candidate - 1;
+                while (position > anchor && match > 0 && input[position - 1] == input[match - 1]) {
+                    position--;
+                    match--;
+                }
+
+                size_t matchLength = MIN_MATCH;
+                while (position + matchLength < matchEndLimit && input[position + matchLength] == input[match + matchLength]) {
+                    matchLength++;
+                }
+
+                appendSequence(out, input + anchor, position - anchor, static_cast<uint32_t>(position - match), matchLength);
+                position += matchLength;
+                anchor = position;
+            }
+        }
+
+        // final sequence is only literals, without an offset
+        const size_t literalCount = size - anchor;
+        out.push_back(static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4));
+        if (literalCount >= 15) appendLength(out, literalCount - 15);
+        out.insert(out.end(), input + anchor, input + size);
+        return out;
+    }
+
+    bool readLength(const uint8_t*& data, const uint8_t* end, size_t& length) {
+        uint8_t byte;
+        do {
+            if (data == end) return false;
+            byte = *data++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    /// <returns>False if the block is corrupt or doesn't decompress to exactly size bytes</returns>
+    bool decompressChunk(const uint8_t* data, size_t compressedSize, uint8_t* output, size_t size) {
+        const uint8_t* end = data + compressedSize;
+        size_t written = 0;
+
+        while (data < end) {
+            const uint8_t token = *data++;
+
+            size_t literalCount = token >> 4;
+            if (literalCount == 15 && !readLength(data, end, literalCount)) return false;
+            if (literalCount > static_cast<size_t>(end - data) || literalCount > size - written) return false;
+            std::memcpy(output + written, data, literalCount);
+            data += literalCount;
+            written += literalCount;
+
+            if (data == end) break;
+
+            if (end - data < 2) return false;
+            const size_t offset = data[0] | (data[1] << 8);
+            data += 2;
+            if (offset == 0 || offset > written) return false;
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !readLength(data, end, matchLength)) return false;
+            matchLength += MIN_MATCH;
+            if (matchLength > size - written) return false;
+
+            // matches may overlap what they write when repeating a short run, which needs copying forwards byte by byte
+            const uint8_t* source = output + written - offset;
+            if (offset >= matchLength) {
+                std::memcpy(output + written, source, matchLength);
+            } else {
+                for (size_t i = 0; i < matchLength; i++) {
+                    output[written + i] = source[i];
+                }
+            }
+            written += matchLength;
+        }
+
+        return written == size;
+    }
+
+    template<typename T>
+    void appendValue(std::vector<uint8_t>& out, T value) {
+        size_t offset = out.size();
+        out.resize(offset + sizeof(T));
+        std::memcpy(out.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    bool readValue(const uint8_t*& data, const uint8_t* end, T& value) {
+        if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+        std::memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return true;
+    }
+}
+
+AssetPack::AssetPack(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        Debug::exception("failed to open asset pack " + path);
+    }
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    dataSize = static_cast<size_t>(fileSize.QuadPart);
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle) {
+        data = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        Debug::exception("failed to open asset pack " + path);
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0) {
+        dataSize = static_cast<size_t>(fileStat.st_size);
+        void* mapped = mmap(nullptr, dataSize, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapped != MAP_FAILED) data = static_cast<const uint8_t*>(mapped);
+    }
+
+    // the mapping keeps its own reference to the file
+    close(file);
+#endif
+
+    // the destructor doesn't run if the constructor throws, so unmap before reporting anything wrong with the pack
+    auto fail = [&](const std::string& message) {
+        unmap();
+        Debug::exception(message);
+    };
+
+    if (!data) {
+        fail("failed to map asset pack " + path);
+    }
+
+    const uint8_t* end = data + dataSize;
+    const uint8_t* cursor = data;
+    PackHeader header{};
+    if (!readValue(cursor, end, header) || header.magic != PACK_MAGIC || header.version != PACK_VERSION
+        || header.tocOffset > dataSize || header.tocSize > dataSize - header.tocOffset) {
+        fail("asset pack " + path + " is corrupt or from a different version");
+    }
+
+    cursor = data + header.tocOffset;
+    const uint8_t* tocEnd = cursor + header.tocSize;
+    chunks.resize(header.chunkCount);
+    for (auto& chunk : chunks) {
+        if (!readValue(cursor, tocEnd, chunk) || chunk.offset > dataSize || chunk.compressedSize > dataSize - chunk.offset) {
+            fail("asset pack " + path + " has a corrupt chunk table");
+        }
+    }
+
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        uint32_t nameLength;
+        Entry entry;
+        if (!readValue(cursor, tocEnd, nameLength) || nameLength > static_cast<size_t>(tocEnd - cursor)) {
+            fail("asset pack " + path + " has a corrupt table of contents");
+        }
+        std::string name(reinterpret_cast<const char*>(cursor), nameLength);
+        cursor += nameLength;
+
+        if (!readValue(cursor, tocEnd, entry) || entry.firstChunk > chunks.size() || entry.chunkCount > chunks.size() - entry.firstChunk) {
+            fail("asset pack " + path + " has a corrupt table of contents");
+        }
+        entries.emplace(std::move(name), entry);
+    }
+}
+
+AssetPack::~AssetPack() {
+    unmap();
+}
+
+std::vector<char> AssetPack::read(const std::string& name, ThreadPool& threadPool) const {
+    auto found = entries.find(name);
+    if (found == entries.end()) {
+        Debug::exception("asset pack has no file " + name);
+    }
+    const Entry& entry = found->second;
+
+    std::vector<char> file(entry.size);
+    uint8_t* output = reinterpret_cast<uint8_t*>(file.data());
+
+    // every chunk but the last is CHUNK_SIZE bytes, so each knows where it goes without waiting on the others
+    threadPool.parallelFor(entry.chunkCount, 1, [&](uint32_t i) {
+        const Chunk& chunk = chunks[entry.firstChunk + i];
+        const uint64_t outputOffset = static_cast<uint64_t>(i) * CHUNK_SIZE;
+        if (outputOffset > entry.size || chunk.size > entry.size - outputOffset) {
+            Debug::exception("asset pack file " + name + " is corrupt");
+        }
+
+        if (chunk.compressedSize == chunk.size) {
+            std::memcpy(output + outputOffset, data + chunk.offset, chunk.size);
+        } else if (!decompressChunk(data + chunk.offset, chunk.compressedSize, output + outputOffset, chunk.size)) {
+            Debug::exception("asset pack file " + name + " is corrupt");
+        }
+    });
+
+    return file;
+}
+
+void AssetPack::unmap() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+#else
+    if (data) munmap(const_cast<uint8_t*>(data), dataSize);
+#endif
+    data = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+
+bool AssetPack::write(const std::string& path, const std::vector<std::string>& files, ThreadPool& threadPool) {
+    std::vector<uint8_t> toc;
+    std::vector<Chunk> packChunks;
+    uint32_t entryCount = 0;
+
+    // written to a temporary file first so a failed write never leaves a truncated pack behind
+    const std::string tempPath = path + ".tmp";
+    bool written = false;
+    {
+        std::ofstream pack(tempPath, std::ios::binary | std::ios::trunc);
+        if (!pack.is_open()) return false;
+
+        PackHeader header{};
+        pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        uint64_t offset = sizeof(header);
+
+        for (const auto& name : files) {
+            std::ifstream file(name, std::ios::ate | std::ios::binary);
+            if (!file.is_open()) continue;
+
+            std::vector<uint8_t> contents(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(contents.data()), contents.size());
+
+            Entry entry{};
+            entry.size = contents.size();
+            entry.firstChunk = static_cast<uint32_t>(packChunks.size());
+            entry.chunkCount = static_cast<uint32_t>((contents.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+            std::vector<std::vector<uint8_t>> compressed(entry.chunkCount);
+            threadPool.parallelFor(entry.chunkCount, 1, [&](uint32_t i) {
+                const size_t chunkOffset = static_cast<size_t>(i) * CHUNK_SIZE;
+                const size_t chunkSize = std::min<size_t>(CHUNK_SIZE, contents.size() - chunkOffset);
+                compressed[i] = compressChunk(contents.data() + chunkOffset, chunkSize);
+
+                // already compressed files such as pngs are stored as they are
+                if (compressed[i].size() >= chunkSize) {
+                    compressed[i].assign(contents.begin() + chunkOffset, contents.begin() + chunkOffset + chunkSize);
+                }
+            });
+
+            for (uint32_t i = 0; i < entry.chunkCount; i++) {
+                const size_t chunkSize = std::min<size_t>(CHUNK_SIZE, contents.size() - static_cast<size_t>(i) * CHUNK_SIZE);
+                packChunks.push_back({ offset, static_cast<uint32_t>(compressed[i].size()), static_cast<uint32_t>(chunkSize) });
+                pack.write(reinterpret_cast<const char*>(compressed[i].data()), compressed[i].size());
+                offset += compressed[i].size();
+            }
+
+            appendValue(toc, static_cast<uint32_t>(name.size()));
+            toc.insert(toc.end(), name.begin(), name.end());
+            appendValue(toc, entry);
+            entryCount++;
+        }
+
+        // the chunk table goes first in the table of contents as entries refer to it
+        std::vector<uint8_t> chunkTable;
+        for (const auto& chunk : packChunks) {
+            appendValue(chunkTable, chunk);
+        }
+        pack.write(reinterpret_cast<const char*>(chunkTable.data()), chunkTable.size());
+        pack.write(reinterpret_cast<const char*>(toc.data()), toc.size());
+
+        header.magic = PACK_MAGIC;
+        header.version = PACK_VERSION;
+        header.entryCount = entryCount;
+        header.chunkCount = static_cast<uint32_t>(packChunks.size());
+        header.tocOffset = offset;
+        header.tocSize = chunkTable.size() + toc.size();
+        pack.seekp(0);
+        pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        written = static_cast<bool>(pack);
+    }
+
+    std::error_code error;
+    if (!written) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+bool AssetPack::isStale(const std::string& path, const std::vector<std::string>& files) {
+    std::error_code error;
+    auto packTime = std::filesystem::last_write_time(path, error);
+    if (error) return true;
+
+    for (const auto& file : files) {
+        auto fileTime = std::filesystem::last_write_time(file, error);
+        if (!error && fileTime > packTime) return true;
+    }
+    return false;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+/// <summary>
+/// Read only archive of asset files, mapped into memory once. Each file is split into independently
+/// LZ4 compressed chunks so a file's chunks decompress in parallel, found by name in the table of contents
+/// </summary>
+class AssetPack {
+public:
+	/// <summary>
+	/// Maps the pack and reads its table of contents
+	/// </summary>
+	AssetPack(const std::string& path);
+	~AssetPack();
+
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	const bool contains(const std::string& name) const { return entries.find(name) != entries.end(); }
+
+	/// <summary>
+	/// Decompresses a file's chunks in parallel on the pool, safe to call from any thread including the pool's workers
+	/// </summary>
+	std::vector<char> read(const std::string& name, ThreadPool& threadPool) const;
+
+	/// <summary>
+	/// Packs the files that exist under their paths as names, files that don't exist are left out
+	/// </summary>
+	/// <returns>False if the pack couldn't be written</returns>
+	static bool write(const std::string& path, const std::vector<std::string>& files, ThreadPool& threadPool);
+
+	/// <returns>True if the pack doesn't exist or any of the files that exist were changed after it was written</returns>
+	static bool isStale(const std::string& path, const std::vector<std::string>& files);
+
+	/// <summary>
+	/// Bytes of a file in each compressed chunk, large enough to compress well and small enough to split files across the workers
+	/// </summary>
+	static constexpr uint32_t CHUNK_SIZE = 256u << 10;
+
+private:
+	struct Entry {
+		uint64_t size;
+		uint32_t firstChunk;
+		uint32_t chunkCount;
+	};
+
+	struct Chunk {
+		uint64_t offset;
+		uint32_t compressedSize;
+
+		/// <summary>
+		/// Stored uncompressed if equal to compressedSize
+		/// </summary>
+		uint32_t size;
+	};
+
+private:
+	void unmap();
+
+private:
+	const uint8_t* data = nullptr;
+	size_t dataSize = 0;
+
+	/// <summary>
+	/// Platform file and mapping handles, kept open for as long as the pack is mapped
+	/// </summary>
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+
+	std::unordered_map<std::string, Entry> entries;
+	std::vector<Chunk> chunks;
+};
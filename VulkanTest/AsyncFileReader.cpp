@@ -0,0 +1,346 @@
+#include "AsyncFileReader.h"
+#include "ThreadPool.h"
+#include "Debug.h"
+
+#include <fstream>
+
+#ifdef __linux__
+#define ASYNC_FILE_READER_IO_URING
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef ASYNC_FILE_READER_IO_URING
+namespace {
+    /// <summary>
+    /// Largest single read, reads of bigger files are resubmitted from where the last one stopped
+    /// </summary>
+    constexpr size_t MAX_READ_SIZE = 1u << 30;
+
+    /// <summary>
+    /// User data of the no op submitted to wake the completion thread when stopping
+    /// </summary>
+    constexpr uint64_t WAKE_USER_DATA = 0;
+
+    inline uint32_t loadAcquire(uint32_t* value) {
+        return std::atomic_ref<uint32_t>(*value).load(std::memory_order_acquire);
+    }
+
+    inline void storeRelease(uint32_t* value, uint32_t newValue) {
+        std::atomic_ref<uint32_t>(*value).store(newValue, std::memory_order_release);
+    }
+}
+
+/// <summary>
+/// Submission and completion rings shared with the kernel, see io_uring_setup(2)
+/// </summary>
+struct AsyncFileReader::Ring {
+    int fd = -1;
+    uint32_t entries = 0;
+
+    void* ringMemory = nullptr;
+    size_t ringMemorySize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    uint32_t* sqHead = nullptr;
+    uint32_t* sqTail = nullptr;
+    uint32_t* sqMask = nullptr;
+    uint32_t* sqArray = nullptr;
+
+    uint32_t* cqHead = nullptr;
+    uint32_t* cqTail = nullptr;
+    uint32_t* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    /// <summary>
+    /// Guards the submission ring and everything below, submissions come from any thread and resubmissions from the completion thread
+    /// </summary>
+    std::mutex mutex;
+    uint32_t inFlight = 0;
+    std::deque<ReadRequest*> waiting;
+    bool stopping = false;
+
+    std::thread completionThread;
+
+    ~Ring() {
+        if (sqes) munmap(sqes, sqesSize);
+        if (ringMemory) munmap(ringMemory, ringMemorySize);
+        if (fd >= 0) close(fd);
+    }
+
+    /// <returns>False if the kernel doesn't support io_uring or its reads, or it isn't allowed</returns>
+    bool setup(uint32_t queueDepth) {
+        io_uring_params params{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+        if (fd < 0) return false;
+
+        // the submission and completion rings share one mapping, older kernels without it aren't worth supporting
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP)) return false;
+
+        // IORING_OP_READ needs Linux 5.6, as does the probe, so a kernel that can't be probed can't read either
+        std::vector<uint8_t> probeMemory(sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeMemory.data());
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0) return false;
+        if (probe->last_op < IORING_OP_READ || !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED)) return false;
+
+        entries = params.sq_entries;
+        ringMemorySize = std::max(params.sq_off.array + params.sq_entries * sizeof(uint32_t), params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        void* mapped = mmap(nullptr, ringMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (mapped == MAP_FAILED) return false;
+        ringMemory = mapped;
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        mapped = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (mapped == MAP_FAILED) return false;
+        sqes = static_cast<io_uring_sqe*>(mapped);
+
+        uint8_t* base = static_cast<uint8_t*>(ringMemory);
+        sqHead = reinterpret_cast<uint32_t*>(base + params.sq_off.head);
+        sqTail = reinterpret_cast<uint32_t*>(base + params.sq_off.tail);
+        sqMask = reinterpret_cast<uint32_t*>(base + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<uint32_t*>(base + params.sq_off.array);
+        cqHead = reinterpret_cast<uint32_t*>(base + params.cq_off.head);
+        cqTail = reinterpret_cast<uint32_t*>(base + params.cq_off.tail);
+        cqMask = reinterpret_cast<uint32_t*>(base + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+        return true;
+    }
+
+    /// <summary>
+    /// Queues one entry and submits it straight away, call with the mutex held.
+    /// The kernel takes every entry on submit so the ring always has space while inFlight is below entries
+    /// </summary>
+    /// <returns>False if the kernel refused the entry, such as while its completion ring is full, leaving it unqueued</returns>
+    bool push(uint8_t opcode, int file, void* buffer, uint32_t length, uint64_t offset, uint64_t userData) {
+        const uint32_t tail = *sqTail;
+        const uint32_t index = tail & *sqMask;
+
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = file;
+        sqe.addr = reinterpret_cast<uint64_t>(buffer);
+        sqe.len = length;
+        sqe.off = offset;
+        sqe.user_data = userData;
+
+        sqArray[index] = index;
+        storeRelease(sqTail, tail + 1);
+
+        long submitted;
+        while ((submitted = syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0)) < 0 && errno == EINTR) {}
+        if (submitted == 1) return true;
+
+        // entries are only taken during io_uring_enter, so one it didn't take can be taken back before the next
+        Debug::log("io_uring_enter failed to submit: " + std::string(std::strerror(errno)));
+        if (loadAcquire(sqHead) == tail) {
+            storeRelease(sqTail, tail);
+            return false;
+        }
+        return true;
+    }
+
+    /// <returns>False if the read couldn't be submitted, see push</returns>
+    bool pushRead(ReadRequest& request) {
+        const size_t length = std::min(request.data.size() - request.bytesRead, MAX_READ_SIZE);
+        return push(IORING_OP_READ, request.file, request.data.data() + request.bytesRead, static_cast<uint32_t>(length), request.bytesRead, reinterpret_cast<uint64_t>(&request));
+    }
+};
+#else
+struct AsyncFileReader::Ring {};
+#endif
+
+AsyncFileReader::AsyncFileReader(ThreadPool& threadPool, uint32_t queueDepth) : threadPool(threadPool) {
+#ifdef ASYNC_FILE_READER_IO_URING
+    auto newRing = std::make_unique<Ring>();
+    if (newRing->setup(queueDepth)) {
+        ring = std::move(newRing);
+        ring->completionThread = std::thread(&AsyncFileReader::completionLoop, this);
+    } else {
+        Debug::log("io_uring is unavailable, reading files on the thread pool instead");
+    }
+#endif
+}
+
+AsyncFileReader::~AsyncFileReader() {
+#ifdef ASYNC_FILE_READER_IO_URING
+    if (!ring) return;
+
+    // the no op's completion wakes the completion thread to see it should stop, retried until the kernel has room for it
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(ring->mutex);
+            ring->stopping = true;
+            if (ring->push(IORING_OP_NOP, -1, nullptr, 0, 0, WAKE_USER_DATA)) {
+                ring->inFlight++;
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ring->completionThread.join();
+#endif
+}
+
+void AsyncFileReader::submit(ReadRequest& request) {
+#ifdef ASYNC_FILE_READER_IO_URING
+    if (ring) {
+        // opening and sizing the file are quick metadata calls, only the read itself goes through the ring
+        request.file = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat fileStat;
+        if (request.file < 0 || fstat(request.file, &fileStat) != 0) {
+            request.failed = true;
+            resume(request);
+            return;
+        }
+
+        request.data.resize(static_cast<size_t>(fileStat.st_size));
+        if (request.data.empty()) {
+            resume(request);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(ring->mutex);
+        if (ring->inFlight >= ring->entries) {
+            ring->waiting.push_back(&request);
+        } else if (ring->pushRead(request)) {
+            ring->inFlight++;
+        } else {
+            readOnPool(request);
+        }
+        return;
+    }
+#endif
+
+    readOnPool(request);
+}
+
+void AsyncFileReader::readOnPool(ReadRequest& request) {
+#ifdef ASYNC_FILE_READER_IO_URING
+    // anything the ring read already is read again from the start
+    if (request.file >= 0) {
+        close(request.file);
+        request.file = -1;
+    }
+    request.bytesRead = 0;
+#endif
+
+    threadPool.submit([&request]() {
+        readBlocking(request);
+        request.handle.resume();
+    });
+}
+
+void AsyncFileReader::readBlocking(ReadRequest& request) {
+    std::ifstream file(request.path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        request.failed = true;
+        return;
+    }
+
+    request.data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    request.failed = !file.read(request.data.data(), request.data.size());
+}
+
+std::vector<char> AsyncFileReader::takeData(ReadRequest& request) {
+    if (request.failed) {
+        Debug::exception("failed to read file " + request.path);
+    }
+    return std::move(request.data);
+}
+
+void AsyncFileReader::resume(ReadRequest& request) {
+#ifdef ASYNC_FILE_READER_IO_URING
+    if (request.file >= 0) {
+        close(request.file);
+        request.file = -1;
+    }
+#endif
+
+    std::coroutine_handle<> handle = request.handle;
+    threadPool.submit([handle]() { handle.resume(); });
+}
+
+void AsyncFileReader::completionLoop() {
+#ifdef ASYNC_FILE_READER_IO_URING
+    int lastWaitError = 0;
+    while (true) {
+        if (syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+            // EBUSY means completions are waiting to be reaped, anything else is waited out rather than spun on
+            if (errno != EBUSY) {
+                if (errno != lastWaitError) Debug::log("io_uring_enter failed waiting for reads: " + std::string(std::strerror(errno)));
+                lastWaitError = errno;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        uint32_t head = *ring->cqHead;
+        const uint32_t tail = loadAcquire(ring->cqTail);
+
+        std::lock_guard<std::mutex> lock(ring->mutex);
+        for (; head != tail; head++) {
+            const io_uring_cqe& cqe = ring->cqes[head & *ring->cqMask];
+            if (cqe.user_data == WAKE_USER_DATA) {
+                ring->inFlight--;
+                continue;
+            }
+
+            ReadRequest& request = *reinterpret_cast<ReadRequest*>(cqe.user_data);
+            if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                if (!ring->pushRead(request)) {
+                    ring->inFlight--;
+                    readOnPool(request);
+                }
+                continue;
+            }
+
+            if (cqe.res < 0) {
+                request.failed = true;
+            } else if (cqe.res == 0) {
+                // the file shrank after it was sized
+                request.data.resize(request.bytesRead);
+            } else {
+                request.bytesRead += cqe.res;
+                if (request.bytesRead < request.data.size()) {
+                    if (!ring->pushRead(request)) {
+                        ring->inFlight--;
+                        readOnPool(request);
+                    }
+                    continue;
+                }
+            }
+
+            ring->inFlight--;
+            resume(request);
+        }
+        storeRelease(ring->cqHead, head);
+
+        // finished reads make room for those waiting
+        while (!ring->waiting.empty() && ring->inFlight < ring->entries) {
+            ReadRequest& request = *ring->waiting.front();
+            ring->waiting.pop_front();
+            if (ring->pushRead(request)) {
+                ring->inFlight++;
+            } else {
+                readOnPool(request);
+            }
+        }
+
+        if (ring->stopping && ring->inFlight == 0 && ring->waiting.empty()) return;
+    }
+#endif
+}
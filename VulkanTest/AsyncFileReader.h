@@ -0,0 +1,96 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+/// <summary>
+/// Reads whole files without blocking the awaiting thread. On Linux reads are queued on an io_uring so hundreds
+/// can be in flight at once, elsewhere or if io_uring is unavailable each read blocks a worker of the pool instead.
+/// Awaiting coroutines are resumed on the pool once their file has been read
+/// </summary>
+class AsyncFileReader {
+public:
+	/// <param name="queueDepth">Reads in flight at once, more wait until one finishes</param>
+	AsyncFileReader(ThreadPool& threadPool, uint32_t queueDepth = 256);
+
+	/// <summary>
+	/// Only call once no reads are in flight, as they resume coroutines that rely on the reader
+	/// </summary>
+	~AsyncFileReader();
+
+	struct ReadRequest {
+		std::string path;
+		std::vector<char> data;
+		bool failed = false;
+		std::coroutine_handle<> handle;
+
+		/// <summary>
+		/// Open file and how much of it has been read, only used by io_uring
+		/// </summary>
+		int file = -1;
+		size_t bytesRead = 0;
+	};
+
+	/// <summary>
+	/// Awaiting the result reads the whole file, throwing if it couldn't be read
+	/// </summary>
+	auto read(std::string path) {
+		struct ReadAwaiter {
+			AsyncFileReader& fileReader;
+			ReadRequest request;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) {
+				request.handle = handle;
+				fileReader.submit(request);
+			}
+			std::vector<char> await_resume() { return takeData(request); }
+		};
+		ReadAwaiter awaiter{ *this };
+		awaiter.request.path = std::move(path);
+		return awaiter;
+	}
+
+	const bool isUsingIoUring() const { return ring != nullptr; }
+
+private:
+	/// <summary>
+	/// Starts reading the file, the request must stay alive until its handle is resumed
+	/// </summary>
+	void submit(ReadRequest& request);
+
+	/// <summary>
+	/// Reads the file on a worker of the pool, used without io_uring and for reads the ring couldn't take
+	/// </summary>
+	void readOnPool(ReadRequest& request);
+
+	/// <summary>
+	/// Blocking read used by the pool fallback
+	/// </summary>
+	static void readBlocking(ReadRequest& request);
+
+	/// <summary>
+	/// Moves the file out of a finished request, throwing if it failed
+	/// </summary>
+	static std::vector<char> takeData(ReadRequest& request);
+
+	void resume(ReadRequest& request);
+
+	/// <summary>
+	/// Reaps completions, resubmitting partial reads, until stopped with nothing in flight
+	/// </summary>
+	void completionLoop();
+
+private:
+	ThreadPool& threadPool;
+
+	/// <summary>
+	/// io_uring state, null when reads fall back to the pool
+	/// </summary>
+	struct Ring;
+	std::unique_ptr<Ring> ring;
+};
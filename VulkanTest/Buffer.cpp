@@ -6,6 +6,8 @@
 #include "PhysicalDevice.h"
 #include "CommandPool.h"
 
+#include <vector>
+
 Buffer::Buffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, VkDeviceSize size, VkBufferUsageFlags flags, VkMemoryPropertyFlags properties) :
     device(device), size(size) {
     QueueFamilyIndices indices = physicalDevice->getQueueFamilyIndices();
@@ -46,20 +48,22 @@ Buffer::~Buffer() {
     vkFreeMemory(device->getDevice(), bufferMemory, nullptr);
 }
 
-void Buffer::copyFromData(void* inputData) {
+void Buffer::copyFromData(const void* inputData) {
     void* data;
     vkMapMemory(device->getDevice(), bufferMemory, 0, size, 0, &data);
     std::memcpy(data, inputData, static_cast<size_t>(size));
     vkUnmapMemory(device->getDevice(), bufferMemory);
 }
 
-void Buffer::copyFromBuffer(const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const std::unique_ptr<Buffer>& source) {
+void Buffer::copyFromBuffer(const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const std::unique_ptr<Buffer>& source,
+                            VkDeviceSize dstOffset) {
     QueueFamilyIndices indices = physicalDevice->getQueueFamilyIndices();
 
     VkCommandBuffer commandBuffer = transferPool->beginSingleTimeCommands();
 
     VkBufferCopy copyRegion{};
-    copyRegion.size = size;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = source->size;
     vkCmdCopyBuffer(commandBuffer, source->buffer, buffer, 1, &copyRegion);
 
     // setup barrier for queue transfer @TODO check queues are different
@@ -68,8 +72,8 @@ void Buffer::copyFromBuffer(const std::unique_ptr<PhysicalDevice>& physicalDevic
     barrier.srcQueueFamilyIndex = indices.transferFamilyOnly.value();
     barrier.dstQueueFamilyIndex = indices.graphicsFamily.value();
     barrier.buffer = buffer;
-    barrier.offset = 0;
-    barrier.size = size;
+    barrier.offset = dstOffset;
+    barrier.size = source->size;
 
     barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
     barrier.dstAccessMask = 0;
@@ -92,27 +96,36 @@ void Buffer::copyFromBuffer(const std::unique_ptr<PhysicalDevice>& physicalDevic
     graphicsPool->endSingleTimeCommandsTransfer(transferPool, commandBuffer, destCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT);
 }
 
-void Buffer::copyToImage(const std::unique_ptr<CommandPool>& commandPool, VkImage image, uint32_t width, uint32_t height) {
+void Buffer::copyToImage(const std::unique_ptr<CommandPool>& commandPool, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels) {
     VkCommandBuffer copyCmdBuffer = commandPool->beginSingleTimeCommands();
 
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-
-    region.imageOffset = { 0, 0, 0 };
-    region.imageExtent = {
-        width,
-        height,
-        1
-    };
+    std::vector<VkBufferImageCopy> regions(mipLevels);
+    VkDeviceSize offset = 0;
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        VkBufferImageCopy& region = regions[i];
+        region.bufferOffset = offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = i;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = {
+            width,
+            height,
+            1
+        };
+
+        // 8 bit RGBA, same as the only image format copied to
+        offset += static_cast<VkDeviceSize>(width) * height * 4;
+        if (width > 1) width /= 2;
+        if (height > 1) height /= 2;
+    }
 
-    vkCmdCopyBufferToImage(copyCmdBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    vkCmdCopyBufferToImage(copyCmdBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
 
     commandPool->endSingleTimeCommands(copyCmdBuffer);
 }
@@ -120,3 +133,7 @@ void Buffer::copyToImage(const std::unique_ptr<CommandPool>& commandPool, VkImag
 void Buffer::mapMemory(void** target) {
     vkMapMemory(device->getDevice(), bufferMemory, 0, size, 0, target);
 }
+
+void Buffer::unmapMemory() {
+    vkUnmapMemory(device->getDevice(), bufferMemory);
+}
@@ -13,10 +13,19 @@ public:
 
 	const VkBuffer getBuffer() const { return buffer; }
 
-	void copyFromData(void* inputData);
-	void copyFromBuffer(const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const std::unique_ptr<Buffer>& source);
-	void copyToImage(const std::unique_ptr<CommandPool>& commandPool, VkImage image, uint32_t width, uint32_t height);
+	void copyFromData(const void* inputData);
+	/// <summary>
+	/// Copies the whole of the source into this buffer, from dstOffset
+	/// </summary>
+	void copyFromBuffer(const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const std::unique_ptr<Buffer>& source,
+						VkDeviceSize dstOffset = 0);
+
+	/// <summary>
+	/// Copies the buffer's levels, tightly packed from the largest, into the image's first mipLevels levels
+	/// </summary>
+	void copyToImage(const std::unique_ptr<CommandPool>& commandPool, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels = 1);
 	void mapMemory(void** target);
+	void unmapMemory();
 private:
 	VkBuffer buffer;
 	VkDeviceMemory bufferMemory;
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// <summary>
+/// 64 bit FNV-1a hash of file contents, used to tell whether two files or two versions of a file hold the same data
+/// </summary>
+namespace ContentHash {
+	constexpr uint64_t SEED = 0xcbf29ce484222325ull;
+	constexpr uint64_t PRIME = 0x100000001b3ull;
+
+	/// <param name="hash">Hash of the data before this, so data can be hashed in pieces</param>
+	inline uint64_t hash(const void* data, size_t size, uint64_t hash = SEED) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * PRIME;
+		}
+		return hash;
+	}
+
+	/// <summary>
+	/// Hashes the value's bytes least significant first, the same as hash() on little endian machines but usable at compile time
+	/// </summary>
+	constexpr uint64_t hashValue(uint32_t value, uint64_t hash = SEED) {
+		for (uint32_t i = 0; i < sizeof(value); i++) {
+			hash = (hash ^ ((value >> (i * 8)) & 0xff)) * PRIME;
+		}
+		return hash;
+	}
+
+	constexpr uint64_t hashValue(uint64_t value, uint64_t hash = SEED) {
+		hash = hashValue(static_cast<uint32_t>(value), hash);
+		return hashValue(static_cast<uint32_t>(value >> 32), hash);
+	}
+
+	/// <summary>
+	/// Hashes the length then the characters, so moving characters between neighbouring strings changes the hash
+	/// </summary>
+	constexpr uint64_t hashString(std::string_view value, uint64_t hash = SEED) {
+		hash = hashValue(static_cast<uint64_t>(value.size()), hash);
+		for (char c : value) {
+			hash = (hash ^ static_cast<uint8_t>(c)) * PRIME;
+		}
+		return hash;
+	}
+}
@@ -0,0 +1,138 @@
+#include "DynamicState.h"
+
+#include "LogicalDevice.h"
+#include "PipelineManager.h"
+
+namespace {
+    template<typename T>
+    void loadCommand(VkDevice device, const char* name, T& command) {
+        command = reinterpret_cast<T>(vkGetDeviceProcAddr(device, name));
+    }
+
+    /// <summary>
+    /// Without dynamicPrimitiveTopologyUnrestricted the topology set while recording must be of the same class as the pipeline's
+    /// </summary>
+    VkPrimitiveTopology getTopologyClass(VkPrimitiveTopology topology) {
+        switch (topology) {
+            case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+                return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+                return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+            case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+                return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+            default:
+                return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        }
+    }
+}
+
+DynamicState::DynamicState(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice) :
+    support(physicalDevice->getDynamicStateSupport()) {
+    const VkDevice deviceHandle = device->getDevice();
+
+    // the commands aren't exported by the loader, so they're fetched from the device
+    if (support.extendedDynamicState) {
+        loadCommand(deviceHandle, "vkCmdSetCullModeEXT", vkCmdSetCullModeEXT);
+        loadCommand(deviceHandle, "vkCmdSetFrontFaceEXT", vkCmdSetFrontFaceEXT);
+        loadCommand(deviceHandle, "vkCmdSetPrimitiveTopologyEXT", vkCmdSetPrimitiveTopologyEXT);
+        loadCommand(deviceHandle, "vkCmdSetDepthTestEnableEXT", vkCmdSetDepthTestEnableEXT);
+        loadCommand(deviceHandle, "vkCmdSetDepthWriteEnableEXT", vkCmdSetDepthWriteEnableEXT);
+        loadCommand(deviceHandle, "vkCmdSetDepthCompareOpEXT", vkCmdSetDepthCompareOpEXT);
+    }
+    if (support.extendedDynamicState2) {
+        loadCommand(deviceHandle, "vkCmdSetPrimitiveRestartEnableEXT", vkCmdSetPrimitiveRestartEnableEXT);
+    }
+    if (support.polygonMode) {
+        loadCommand(deviceHandle, "vkCmdSetPolygonModeEXT", vkCmdSetPolygonModeEXT);
+    }
+    if (support.colorBlendEnable) {
+        loadCommand(deviceHandle, "vkCmdSetColorBlendEnableEXT", vkCmdSetColorBlendEnableEXT);
+    }
+    if (support.colorBlendEquation) {
+        loadCommand(deviceHandle, "vkCmdSetColorBlendEquationEXT", vkCmdSetColorBlendEquationEXT);
+    }
+}
+
+const std::vector<VkDynamicState> DynamicState::getDynamicStates() const {
+    std::vector<VkDynamicState> dynamicStates = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+
+    if (support.extendedDynamicState) {
+        dynamicStates.insert(dynamicStates.end(), {
+            VK_DYNAMIC_STATE_CULL_MODE_EXT,
+            VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+            VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT,
+            VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+            VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+            VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT
+        });
+    }
+    if (support.extendedDynamicState2) dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT);
+    if (support.polygonMode) dynamicStates.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+    if (support.colorBlendEnable) dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+    if (support.colorBlendEquation) dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT);
+
+    return dynamicStates;
+}
+
+void DynamicState::removeDynamicState(PipelineKey& key) const {
+    PipelineDescription& description = key.description;
+    const PipelineDescription defaults;
+
+    if (support.extendedDynamicState) {
+        description.cullMode = defaults.cullMode;
+        description.frontFace = defaults.frontFace;
+        description.topology = getTopologyClass(description.topology);
+        description.depthTestEnable = defaults.depthTestEnable;
+        description.depthWriteEnable = defaults.depthWriteEnable;
+        description.depthCompareOp = defaults.depthCompareOp;
+    }
+    if (support.extendedDynamicState2) description.primitiveRestartEnable = defaults.primitiveRestartEnable;
+    if (support.polygonMode) description.polygonMode = defaults.polygonMode;
+    if (support.colorBlendEnable) description.blendEnable = defaults.blendEnable;
+    if (support.colorBlendEquation) {
+        description.srcBlendFactor = defaults.srcBlendFactor;
+        description.dstBlendFactor = defaults.dstBlendFactor;
+    }
+    key.rehashDescription();
+}
+
+void DynamicState::record(VkCommandBuffer commandBuffer, const PipelineKey& key) const {
+    const PipelineDescription& description = key.description;
+
+    if (support.extendedDynamicState) {
+        vkCmdSetCullModeEXT(commandBuffer, description.cullMode);
+        vkCmdSetFrontFaceEXT(commandBuffer, description.frontFace);
+        vkCmdSetPrimitiveTopologyEXT(commandBuffer, description.topology);
+        vkCmdSetDepthTestEnableEXT(commandBuffer, description.depthTestEnable ? VK_TRUE : VK_FALSE);
+        vkCmdSetDepthWriteEnableEXT(commandBuffer, description.depthWriteEnable ? VK_TRUE : VK_FALSE);
+        vkCmdSetDepthCompareOpEXT(commandBuffer, description.depthCompareOp);
+    }
+    if (support.extendedDynamicState2) {
+        vkCmdSetPrimitiveRestartEnableEXT(commandBuffer, description.primitiveRestartEnable ? VK_TRUE : VK_FALSE);
+    }
+    if (support.polygonMode) {
+        vkCmdSetPolygonModeEXT(commandBuffer, description.polygonMode);
+    }
+
+    // pipelines have a single colour attachment
+    if (support.colorBlendEnable) {
+        const VkBool32 blendEnable = description.blendEnable ? VK_TRUE : VK_FALSE;
+        vkCmdSetColorBlendEnableEXT(commandBuffer, 0, 1, &blendEnable);
+    }
+    if (support.colorBlendEquation) {
+        VkColorBlendEquationEXT equation{};
+        equation.srcColorBlendFactor = description.srcBlendFactor;
+        equation.dstColorBlendFactor = description.dstBlendFactor;
+        equation.colorBlendOp = VK_BLEND_OP_ADD;
+        equation.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        equation.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        equation.alphaBlendOp = VK_BLEND_OP_ADD;
+        vkCmdSetColorBlendEquationEXT(commandBuffer, 0, 1, &equation);
+    }
+}
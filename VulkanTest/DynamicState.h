@@ -0,0 +1,56 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "PhysicalDevice.h"
+#include <memory>
+#include <vector>
+
+class LogicalDevice;
+struct PipelineKey;
+
+/// <summary>
+/// Pipeline state the device can set while recording with the extended dynamic state extensions, so keys differing
+/// only in it share one pipeline. Without the extensions every state stays baked into the pipelines as before
+/// </summary>
+class DynamicState {
+public:
+	/// <summary>
+	/// Loads the extensions' commands for the features the device supports
+	/// </summary>
+	DynamicState(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice);
+
+	/// <summary>
+	/// States every pipeline leaves to be set while recording, viewport and scissor included
+	/// </summary>
+	const std::vector<VkDynamicState> getDynamicStates() const;
+
+	/// <summary>
+	/// Resets the dynamic parts of the key to fixed values, so keys that only differ in them compile to the same pipeline
+	/// </summary>
+	void removeDynamicState(PipelineKey& key) const;
+
+	/// <summary>
+	/// Sets the dynamic parts of the key, call after binding the pipeline and before drawing
+	/// </summary>
+	void record(VkCommandBuffer commandBuffer, const PipelineKey& key) const;
+
+	const DynamicStateSupport getSupport() const { return support; }
+
+private:
+	DynamicStateSupport support;
+
+	// extended dynamic state
+	PFN_vkCmdSetCullModeEXT vkCmdSetCullModeEXT = nullptr;
+	PFN_vkCmdSetFrontFaceEXT vkCmdSetFrontFaceEXT = nullptr;
+	PFN_vkCmdSetPrimitiveTopologyEXT vkCmdSetPrimitiveTopologyEXT = nullptr;
+	PFN_vkCmdSetDepthTestEnableEXT vkCmdSetDepthTestEnableEXT = nullptr;
+	PFN_vkCmdSetDepthWriteEnableEXT vkCmdSetDepthWriteEnableEXT = nullptr;
+	PFN_vkCmdSetDepthCompareOpEXT vkCmdSetDepthCompareOpEXT = nullptr;
+
+	// extended dynamic state 2
+	PFN_vkCmdSetPrimitiveRestartEnableEXT vkCmdSetPrimitiveRestartEnableEXT = nullptr;
+
+	// extended dynamic state 3
+	PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonModeEXT = nullptr;
+	PFN_vkCmdSetColorBlendEnableEXT vkCmdSetColorBlendEnableEXT = nullptr;
+	PFN_vkCmdSetColorBlendEquationEXT vkCmdSetColorBlendEquationEXT = nullptr;
+};
@@ -0,0 +1,147 @@
+// generated by the AssetCooker from the compiled shaders, don't edit
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace EmbeddedShaders {
+	constexpr uint32_t shaders_frag_spv[] = {
+		0x07230203, 0x00010000, 0x000d000b, 0x00000036, 0x00000000, 0x00020011, 0x00000001, 0x0006000b,
+		0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000, 0x0003000e, 0x00000000, 0x00000001,
+		0x0008000f, 0x00000004, 0x00000004, 0x6e69616d, 0x00000000, 0x00000009, 0x00000011, 0x00000017,
+		0x00030010, 0x00000004, 0x00000007, 0x00030003, 0x00000002, 0x000001c2, 0x000a0004, 0x475f4c47,
+		0x4c474f4f, 0x70635f45, 0x74735f70, 0x5f656c79, 0x656e696c, 0x7269645f, 0x69746365, 0x00006576,
+		0x00080004, 0x475f4c47, 0x4c474f4f, 0x6e695f45, 0x64756c63, 0x69645f65, 0x74636572, 0x00657669,
+		0x00040005, 0x00000004, 0x6e69616d, 0x00000000, 0x00050005, 0x00000009, 0x4374756f, 0x726f6c6f,
+		0x00000000, 0x00050005, 0x0000000d, 0x53786574, 0x6c706d61, 0x00007265, 0x00060005, 0x00000011,
+		0x67617266, 0x43786554, 0x64726f6f, 0x00000000, 0x00050005, 0x00000017, 0x67617266, 0x6f6c6f43,
+		0x00000072, 0x00050005, 0x0000001f, 0x5f455355, 0x54584554, 0x00455255, 0x00070005, 0x00000020,
+		0x5f455355, 0x54524556, 0x435f5845, 0x524f4c4f, 0x00000000, 0x00050005, 0x00000021, 0x48504c41,
+		0x45545f41, 0x00005453, 0x00060005, 0x00000022, 0x48504c41, 0x55435f41, 0x46464f54, 0x00000000,
+		0x00040005, 0x00000024, 0x6f6c6f63, 0x00000072, 0x00040047, 0x00000009, 0x0000001e, 0x00000000,
+		0x00040047, 0x0000000d, 0x00000022, 0x00000000, 0x00040047, 0x0000000d, 0x00000021, 0x00000001,
+		0x00040047, 0x00000011, 0x0000001e, 0x00000001, 0x00040047, 0x00000017, 0x0000001e, 0x00000000,
+		0x00040047, 0x0000001f, 0x00000001, 0x00000000, 0x00040047, 0x00000020, 0x00000001, 0x00000001,
+		0x00040047, 0x00000021, 0x00000001, 0x00000002, 0x00040047, 0x00000022, 0x00000001, 0x00000003,
+		0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002, 0x00030016, 0x00000006, 0x00000020,
+		0x00040017, 0x00000007, 0x00000006, 0x00000004, 0x00040020, 0x00000008, 0x00000003, 0x00000007,
+		0x0004003b, 0x00000008, 0x00000009, 0x00000003, 0x00090019, 0x0000000a, 0x00000006, 0x00000001,
+		0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000000, 0x0003001b, 0x0000000b, 0x0000000a,
+		0x00040020, 0x0000000c, 0x00000000, 0x0000000b, 0x0004003b, 0x0000000c, 0x0000000d, 0x00000000,
+		0x00040017, 0x0000000f, 0x00000006, 0x00000002, 0x00040020, 0x00000010, 0x00000001, 0x0000000f,
+		0x0004003b, 0x00000010, 0x00000011, 0x00000001, 0x00040017, 0x00000014, 0x00000006, 0x00000003,
+		0x00040020, 0x00000016, 0x00000001, 0x00000014, 0x0004003b, 0x00000016, 0x00000017, 0x00000001,
+		0x0004002b, 0x00000006, 0x0000001a, 0x3f800000, 0x00020014, 0x0000001e, 0x00030030, 0x0000001e,
+		0x0000001f, 0x00030030, 0x0000001e, 0x00000020, 0x00030031, 0x0000001e, 0x00000021, 0x00040032,
+		0x00000006, 0x00000022, 0x3f000000, 0x00040020, 0x00000023, 0x00000007, 0x00000007, 0x0007002c,
+		0x00000007, 0x00000025, 0x0000001a, 0x0000001a, 0x0000001a, 0x0000001a, 0x00050036, 0x00000002,
+		0x00000004, 0x00000000, 0x00000003, 0x000200f8, 0x00000005, 0x0004003b, 0x00000023, 0x00000024,
+		0x00000007, 0x000300f7, 0x00000028, 0x00000000, 0x000400fa, 0x0000001f, 0x00000026, 0x00000027,
+		0x000200f8, 0x00000026, 0x0004003d, 0x0000000b, 0x0000000e, 0x0000000d, 0x0004003d, 0x0000000f,
+		0x00000012, 0x00000011, 0x00050057, 0x00000007, 0x00000013, 0x0000000e, 0x00000012, 0x000200f9,
+		0x00000028, 0x000200f8, 0x00000027, 0x000200f9, 0x00000028, 0x000200f8, 0x00000028, 0x000700f5,
+		0x00000007, 0x00000029, 0x00000013, 0x00000026, 0x00000025, 0x00000027, 0x0003003e, 0x00000024,
+		0x00000029, 0x000300f7, 0x0000002b, 0x00000000, 0x000400fa, 0x00000020, 0x0000002a, 0x0000002b,
+		0x000200f8, 0x0000002a, 0x0004003d, 0x00000007, 0x0000002c, 0x00000024, 0x0008004f, 0x00000014,
+		0x00000015, 0x0000002c, 0x0000002c, 0x00000000, 0x00000001, 0x00000002, 0x0004003d, 0x00000014,
+		0x00000018, 0x00000017, 0x00050085, 0x00000014, 0x00000019, 0x00000015, 0x00000018, 0x0009004f,
+		0x00000007, 0x0000002d, 0x0000002c, 0x00000019, 0x00000004, 0x00000005, 0x00000006, 0x00000003,
+		0x0003003e, 0x00000024, 0x0000002d, 0x000200f9, 0x0000002b, 0x000200f8, 0x0000002b, 0x0004003d,
+		0x00000007, 0x0000002e, 0x00000024, 0x00050051, 0x00000006, 0x0000002f, 0x0000002e, 0x00000003,
+		0x000500b8, 0x0000001e, 0x00000030, 0x0000002f, 0x00000022, 0x000500a7, 0x0000001e, 0x00000031,
+		0x00000021, 0x00000030, 0x000300f7, 0x00000033, 0x00000000, 0x000400fa, 0x00000031, 0x00000032,
+		0x00000033, 0x000200f8, 0x00000032, 0x000100fc, 0x000200f8, 0x00000033, 0x0004003d, 0x00000007,
+		0x00000034, 0x00000024, 0x00050051, 0x00000006, 0x0000001b, 0x00000034, 0x00000000, 0x00050051,
+		0x00000006, 0x0000001c, 0x00000034, 0x00000001, 0x00050051, 0x00000006, 0x0000001d, 0x00000034,
+		0x00000002, 0x00070050, 0x00000007, 0x00000035, 0x0000001b, 0x0000001c, 0x0000001d, 0x0000001a,
+		0x0003003e, 0x00000009, 0x00000035, 0x000100fd, 0x00010038,
+	};
+
+	constexpr uint32_t shaders_vert_spv[] = {
+		0x07230203, 0x00010000, 0x000d000b, 0x0000003e, 0x00000000, 0x00020011, 0x00000001, 0x0006000b,
+		0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000, 0x0003000e, 0x00000000, 0x00000001,
+		0x000d000f, 0x00000000, 0x00000004, 0x6e69616d, 0x00000000, 0x0000000d, 0x00000021, 0x00000035,
+		0x0000002c, 0x0000002d, 0x00000039, 0x00000031, 0x00000033, 0x00030003, 0x00000002, 0x000001c2,
+		0x000a0004, 0x475f4c47, 0x4c474f4f, 0x70635f45, 0x74735f70, 0x5f656c79, 0x656e696c, 0x7269645f,
+		0x69746365, 0x00006576, 0x00080004, 0x475f4c47, 0x4c474f4f, 0x6e695f45, 0x64756c63, 0x69645f65,
+		0x74636572, 0x00657669, 0x00040005, 0x00000004, 0x6e69616d, 0x00000000, 0x00060005, 0x0000000b,
+		0x505f6c67, 0x65567265, 0x78657472, 0x00000000, 0x00060006, 0x0000000b, 0x00000000, 0x505f6c67,
+		0x7469736f, 0x006e6f69, 0x00070006, 0x0000000b, 0x00000001, 0x505f6c67, 0x746e696f, 0x657a6953,
+		0x00000000, 0x00070006, 0x0000000b, 0x00000002, 0x435f6c67, 0x4470696c, 0x61747369, 0x0065636e,
+		0x00070006, 0x0000000b, 0x00000003, 0x435f6c67, 0x446c6c75, 0x61747369, 0x0065636e, 0x00030005,
+		0x0000000d, 0x00000000, 0x00070005, 0x00000011, 0x66696e55, 0x426d726f, 0x65666675, 0x6a624f72,
+		0x00746365, 0x00050006, 0x00000011, 0x00000000, 0x65646f6d, 0x0000006c, 0x00050006, 0x00000011,
+		0x00000001, 0x77656976, 0x00000000, 0x00050006, 0x00000011, 0x00000002, 0x6a6f7270, 0x00000000,
+		0x00030005, 0x00000013, 0x006f6275, 0x00050005, 0x00000021, 0x6f506e69, 0x69746973, 0x00006e6f,
+		0x00060005, 0x00000035, 0x6e496e69, 0x6e617473, 0x6f4d6563, 0x006c6564, 0x00050005, 0x0000002c,
+		0x67617266, 0x6f6c6f43, 0x00000072, 0x00040005, 0x0000002d, 0x6f436e69, 0x00726f6c, 0x00060005,
+		0x00000039, 0x6e496e69, 0x6e617473, 0x6f436563, 0x00726f6c, 0x00060005, 0x00000031, 0x67617266,
+		0x43786554, 0x64726f6f, 0x00000000, 0x00050005, 0x00000033, 0x65546e69, 0x6f6f4378, 0x00006472,
+		0x00050048, 0x0000000b, 0x00000000, 0x0000000b, 0x00000000, 0x00050048, 0x0000000b, 0x00000001,
+		0x0000000b, 0x00000001, 0x00050048, 0x0000000b, 0x00000002, 0x0000000b, 0x00000003, 0x00050048,
+		0x0000000b, 0x00000003, 0x0000000b, 0x00000004, 0x00030047, 0x0000000b, 0x00000002, 0x00040048,
+		0x00000011, 0x00000000, 0x00000005, 0x00050048, 0x00000011, 0x00000000, 0x00000023, 0x00000000,
+		0x00050048, 0x00000011, 0x00000000, 0x00000007, 0x00000010, 0x00040048, 0x00000011, 0x00000001,
+		0x00000005, 0x00050048, 0x00000011, 0x00000001, 0x00000023, 0x00000040, 0x00050048, 0x00000011,
+		0x00000001, 0x00000007, 0x00000010, 0x00040048, 0x00000011, 0x00000002, 0x00000005, 0x00050048,
+		0x00000011, 0x00000002, 0x00000023, 0x00000080, 0x00050048, 0x00000011, 0x00000002, 0x00000007,
+		0x00000010, 0x00030047, 0x00000011, 0x00000002, 0x00040047, 0x00000013, 0x00000022, 0x00000000,
+		0x00040047, 0x00000013, 0x00000021, 0x00000000, 0x00040047, 0x00000021, 0x0000001e, 0x00000000,
+		0x00040047, 0x00000035, 0x0000001e, 0x00000003, 0x00040047, 0x0000002c, 0x0000001e, 0x00000000,
+		0x00040047, 0x0000002d, 0x0000001e, 0x00000001, 0x00040047, 0x00000039, 0x0000001e, 0x00000007,
+		0x00040047, 0x00000031, 0x0000001e, 0x00000001, 0x00040047, 0x00000033, 0x0000001e, 0x00000002,
+		0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002, 0x00030016, 0x00000006, 0x00000020,
+		0x00040017, 0x00000007, 0x00000006, 0x00000004, 0x00040015, 0x00000008, 0x00000020, 0x00000000,
+		0x0004002b, 0x00000008, 0x00000009, 0x00000001, 0x0004001c, 0x0000000a, 0x00000006, 0x00000009,
+		0x0006001e, 0x0000000b, 0x00000007, 0x00000006, 0x0000000a, 0x0000000a, 0x00040020, 0x0000000c,
+		0x00000003, 0x0000000b, 0x0004003b, 0x0000000c, 0x0000000d, 0x00000003, 0x00040015, 0x0000000e,
+		0x00000020, 0x00000001, 0x0004002b, 0x0000000e, 0x0000000f, 0x00000000, 0x00040018, 0x00000010,
+		0x00000007, 0x00000004, 0x0005001e, 0x00000011, 0x00000010, 0x00000010, 0x00000010, 0x00040020,
+		0x00000012, 0x00000002, 0x00000011, 0x0004003b, 0x00000012, 0x00000013, 0x00000002, 0x0004002b,
+		0x0000000e, 0x00000014, 0x00000002, 0x00040020, 0x00000015, 0x00000002, 0x00000010, 0x0004002b,
+		0x0000000e, 0x00000018, 0x00000001, 0x00040020, 0x00000034, 0x00000001, 0x00000010, 0x0004003b,
+		0x00000034, 0x00000035, 0x00000001, 0x00040017, 0x0000001f, 0x00000006, 0x00000003, 0x00040020,
+		0x00000020, 0x00000001, 0x0000001f, 0x0004003b, 0x00000020, 0x00000021, 0x00000001, 0x0004002b,
+		0x00000006, 0x00000023, 0x3f800000, 0x00040020, 0x00000029, 0x00000003, 0x00000007, 0x00040020,
+		0x0000002b, 0x00000003, 0x0000001f, 0x0004003b, 0x0000002b, 0x0000002c, 0x00000003, 0x0004003b,
+		0x00000020, 0x0000002d, 0x00000001, 0x00040020, 0x00000038, 0x00000001, 0x00000007, 0x0004003b,
+		0x00000038, 0x00000039, 0x00000001, 0x00040017, 0x0000002f, 0x00000006, 0x00000002, 0x00040020,
+		0x00000030, 0x00000003, 0x0000002f, 0x0004003b, 0x00000030, 0x00000031, 0x00000003, 0x00040020,
+		0x00000032, 0x00000001, 0x0000002f, 0x0004003b, 0x00000032, 0x00000033, 0x00000001, 0x00050036,
+		0x00000002, 0x00000004, 0x00000000, 0x00000003, 0x000200f8, 0x00000005, 0x00050041, 0x00000015,
+		0x00000016, 0x00000013, 0x00000014, 0x0004003d, 0x00000010, 0x00000017, 0x00000016, 0x00050041,
+		0x00000015, 0x00000019, 0x00000013, 0x00000018, 0x0004003d, 0x00000010, 0x0000001a, 0x00000019,
+		0x00050092, 0x00000010, 0x0000001b, 0x00000017, 0x0000001a, 0x00050041, 0x00000015, 0x0000001c,
+		0x00000013, 0x0000000f, 0x0004003d, 0x00000010, 0x0000001d, 0x0000001c, 0x00050092, 0x00000010,
+		0x0000001e, 0x0000001b, 0x0000001d, 0x0004003d, 0x00000010, 0x00000036, 0x00000035, 0x00050092,
+		0x00000010, 0x00000037, 0x0000001e, 0x00000036, 0x0004003d, 0x0000001f, 0x00000022, 0x00000021,
+		0x00050051, 0x00000006, 0x00000024, 0x00000022, 0x00000000, 0x00050051, 0x00000006, 0x00000025,
+		0x00000022, 0x00000001, 0x00050051, 0x00000006, 0x00000026, 0x00000022, 0x00000002, 0x00070050,
+		0x00000007, 0x00000027, 0x00000024, 0x00000025, 0x00000026, 0x00000023, 0x00050091, 0x00000007,
+		0x00000028, 0x00000037, 0x00000027, 0x00050041, 0x00000029, 0x0000002a, 0x0000000d, 0x0000000f,
+		0x0003003e, 0x0000002a, 0x00000028, 0x0004003d, 0x0000001f, 0x0000002e, 0x0000002d, 0x0004003d,
+		0x00000007, 0x0000003a, 0x00000039, 0x0008004f, 0x0000001f, 0x0000003b, 0x0000003a, 0x0000003a,
+		0x00000000, 0x00000001, 0x00000002, 0x00050085, 0x0000001f, 0x0000003c, 0x0000002e, 0x0000003b,
+		0x0003003e, 0x0000002c, 0x0000003c, 0x0004003d, 0x0000002f, 0x0000003d, 0x00000033, 0x0003003e,
+		0x00000031, 0x0000003d, 0x000100fd, 0x00010038,
+	};
+
+	struct EmbeddedShader {
+		std::string_view path;
+		std::span<const uint32_t> code;
+	};
+
+	constexpr std::array<EmbeddedShader, 2> SHADERS = {{
+		{ "shaders/frag.spv", shaders_frag_spv },
+		{ "shaders/vert.spv", shaders_vert_spv },
+	}};
+
+	/// <returns>The compiled shader at the path as the app loads it, empty if it isn't embedded</returns>
+	constexpr std::span<const uint32_t> find(std::string_view path) {
+		for (const auto& shader : SHADERS) {
+			if (shader.path == path) return shader.code;
+		}
+		return {};
+	}
+}
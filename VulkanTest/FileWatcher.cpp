@@ -0,0 +1,191 @@
+#include "FileWatcher.h"
+#include "Debug.h"
+
+#ifdef __linux__
+#define FILE_WATCHER_INOTIFY
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef FILE_WATCHER_INOTIFY
+/// <summary>
+/// One inotify watch per directory holding watched files, see inotify(7)
+/// </summary>
+struct FileWatcher::Inotify {
+    int fd = -1;
+
+    /// <summary>
+    /// Written to wake the watch thread when stopping
+    /// </summary>
+    int stopPipe[2] = { -1, -1 };
+
+    struct Directory {
+        int watch;
+        uint32_t fileCount;
+    };
+    std::unordered_map<std::string, Directory> directories;
+    std::unordered_map<int, std::string> watchDirectories;
+
+    ~Inotify() {
+        if (fd >= 0) close(fd);
+        if (stopPipe[0] >= 0) close(stopPipe[0]);
+        if (stopPipe[1] >= 0) close(stopPipe[1]);
+    }
+
+    /// <returns>False if inotify isn't supported or is out of instances</returns>
+    bool setup() {
+        fd = inotify_init1(IN_CLOEXEC);
+        return fd >= 0 && pipe2(stopPipe, O_CLOEXEC) == 0;
+    }
+
+    /// <summary>
+    /// Watches for files in the directory being closed after writing or moved in, as editors often save to a temporary file then rename it
+    /// </summary>
+    void addFile(const std::string& directory) {
+        auto existing = directories.find(directory);
+        if (existing != directories.end()) {
+            existing->second.fileCount++;
+            return;
+        }
+
+        int watch = inotify_add_watch(fd, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch < 0) {
+            // the directory doesn't exist, such as for assets only in the pack, so there's nothing to watch
+            return;
+        }
+
+        directories[directory] = { watch, 1 };
+        watchDirectories[watch] = directory;
+    }
+
+    void removeFile(const std::string& directory) {
+        auto existing = directories.find(directory);
+        if (existing == directories.end() || --existing->second.fileCount > 0) return;
+
+        inotify_rm_watch(fd, existing->second.watch);
+        watchDirectories.erase(existing->second.watch);
+        directories.erase(existing);
+    }
+};
+#else
+struct FileWatcher::Inotify {};
+#endif
+
+namespace {
+    std::string getDirectory(const std::string& path) {
+        return std::filesystem::path(path).parent_path().generic_string();
+    }
+}
+
+FileWatcher::FileWatcher() {
+#ifdef FILE_WATCHER_INOTIFY
+    auto newInotify = std::make_unique<Inotify>();
+    if (newInotify->setup()) {
+        inotify = std::move(newInotify);
+    } else {
+        Debug::log("inotify is unavailable, polling watched files instead");
+    }
+#endif
+
+    thread = std::thread(&FileWatcher::watchLoop, this);
+}
+
+FileWatcher::~FileWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    stopCondition.notify_all();
+
+#ifdef FILE_WATCHER_INOTIFY
+    if (inotify) {
+        const char stop = 0;
+        while (write(inotify->stopPipe[1], &stop, 1) < 0 && errno == EINTR) {}
+    }
+#endif
+
+    thread.join();
+}
+
+void FileWatcher::watch(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (files.count(path)) return;
+
+    std::error_code timeError;
+    files[path] = std::filesystem::last_write_time(path, timeError);
+
+#ifdef FILE_WATCHER_INOTIFY
+    if (inotify) inotify->addFile(getDirectory(path));
+#endif
+}
+
+void FileWatcher::unwatch(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (files.erase(path) == 0) return;
+    changed.erase(path);
+
+#ifdef FILE_WATCHER_INOTIFY
+    if (inotify) inotify->removeFile(getDirectory(path));
+#endif
+}
+
+std::vector<std::string> FileWatcher::takeChanged() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> paths(changed.begin(), changed.end());
+    changed.clear();
+    return paths;
+}
+
+void FileWatcher::watchLoop() {
+#ifdef FILE_WATCHER_INOTIFY
+    if (inotify) {
+        // large enough for many events at once, aligned as the events hold ints
+        alignas(inotify_event) char buffer[16 * 1024];
+
+        while (true) {
+            pollfd pollFds[2] = { { inotify->fd, POLLIN, 0 }, { inotify->stopPipe[0], POLLIN, 0 } };
+            if (poll(pollFds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            if (pollFds[1].revents) return;
+
+            ssize_t length = read(inotify->fd, buffer, sizeof(buffer));
+            if (length <= 0) continue;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            for (ssize_t offset = 0; offset < length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                auto directory = inotify->watchDirectories.find(event->wd);
+                if (event->len == 0 || directory == inotify->watchDirectories.end()) continue;
+
+                // the directory's other files aren't watched
+                const std::string path = (std::filesystem::path(directory->second) / event->name).generic_string();
+                if (files.count(path)) changed.insert(path);
+            }
+        }
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopCondition.wait_for(lock, POLL_INTERVAL, [this]() { return stopping; })) {
+        pollFiles();
+    }
+}
+
+void FileWatcher::pollFiles() {
+    for (auto& [path, writeTime] : files) {
+        // files being replaced can briefly not exist, they are seen on a later poll
+        std::error_code timeError;
+        auto newWriteTime = std::filesystem::last_write_time(path, timeError);
+        if (timeError || newWriteTime == writeTime) continue;
+
+        writeTime = newWriteTime;
+        changed.insert(path);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// <summary>
+/// Watches files for changes on its own thread. On Linux inotify watches each file's directory, so files replaced
+/// by a rename are still seen, elsewhere or if inotify is unavailable the files' write times are polled instead
+/// </summary>
+class FileWatcher {
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	/// <summary>
+	/// Starts watching the file, which doesn't need to exist yet
+	/// </summary>
+	void watch(const std::string& path);
+	void unwatch(const std::string& path);
+
+	/// <summary>
+	/// Paths that changed since the last call, each only once however many times it was written
+	/// </summary>
+	std::vector<std::string> takeChanged();
+
+	const bool isUsingInotify() const { return inotify != nullptr; }
+
+	/// <summary>
+	/// How often write times are checked when polling
+	/// </summary>
+	static constexpr std::chrono::milliseconds POLL_INTERVAL{ 250 };
+
+private:
+	void watchLoop();
+
+	/// <summary>
+	/// Checks every watched file's write time, call with the mutex held
+	/// </summary>
+	void pollFiles();
+
+private:
+	std::mutex mutex;
+
+	/// <summary>
+	/// Watched paths and their last seen write time, only used when polling
+	/// </summary>
+	std::unordered_map<std::string, std::filesystem::file_time_type> files;
+	std::unordered_set<std::string> changed;
+
+	bool stopping = false;
+	std::condition_variable stopCondition;
+	std::thread thread;
+
+	/// <summary>
+	/// inotify state, null when polling
+	/// </summary>
+	struct Inotify;
+	std::unique_ptr<Inotify> inotify;
+};
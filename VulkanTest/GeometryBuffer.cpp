@@ -0,0 +1,95 @@
+#include "GeometryBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Buffer.h"
+#include "PhysicalDevice.h"
+#include "Structures.h"
+#include "Debug.h"
+
+GeometryBuffer::GeometryBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity) :
+    vertexAllocator(vertexCapacity), indexAllocator(indexCapacity), vertexStride(vertexStride), maxDrawIndirectCount(physicalDevice->getMaxDrawIndirectCount()),
+    device(device), physicalDevice(physicalDevice) {
+    // storage usage too so compute culling or mesh shaders can read the vertices directly
+    vertexBuffer = std::make_unique<Buffer>(device, physicalDevice, static_cast<VkDeviceSize>(vertexStride) * vertexCapacity,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    indexBuffer = std::make_unique<Buffer>(device, physicalDevice, sizeof(uint16_t) * static_cast<VkDeviceSize>(indexCapacity),
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    indirectBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    for (IndirectBuffer& indirectBuffer : indirectBuffers) {
+        createIndirectBuffer(indirectBuffer, 1);
+    }
+}
+
+GeometryBuffer::~GeometryBuffer() = default;
+
+GeometryAllocation GeometryBuffer::allocate(uint32_t vertexCount, uint32_t indexCount) {
+    const std::optional<uint32_t> firstVertex = vertexAllocator.allocate(vertexCount);
+    if (!firstVertex) {
+        Debug::exception("geometry buffer is out of room for vertices, raise GEOMETRY_VERTEX_CAPACITY");
+    }
+
+    const std::optional<uint32_t> firstIndex = indexAllocator.allocate(indexCount);
+    if (!firstIndex) {
+        vertexAllocator.free(*firstVertex, vertexCount);
+        Debug::exception("geometry buffer is out of room for indices, raise GEOMETRY_INDEX_CAPACITY");
+    }
+
+    return { *firstVertex, vertexCount, *firstIndex, indexCount };
+}
+
+void GeometryBuffer::free(const GeometryAllocation& allocation) {
+    vertexAllocator.free(allocation.firstVertex, allocation.vertexCount);
+    indexAllocator.free(allocation.firstIndex, allocation.indexCount);
+}
+
+void GeometryBuffer::upload(const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const GeometryAllocation& allocation,
+                            const std::unique_ptr<Buffer>& vertices, const std::unique_ptr<Buffer>& indices) {
+    // frames in flight only read other meshes' ranges, so the copies don't need to wait for them
+    vertexBuffer->copyFromBuffer(physicalDevice, graphicsPool, transferPool, vertices, static_cast<VkDeviceSize>(allocation.firstVertex) * vertexStride);
+    indexBuffer->copyFromBuffer(physicalDevice, graphicsPool, transferPool, indices, sizeof(uint16_t) * static_cast<VkDeviceSize>(allocation.firstIndex));
+}
+
+void GeometryBuffer::bind(VkCommandBuffer commandBuffer) const {
+    const VkDeviceSize offset = 0;
+    const VkBuffer buffer = vertexBuffer->getBuffer();
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT16);
+}
+
+void GeometryBuffer::drawIndirect(VkCommandBuffer commandBuffer, uint32_t frame, const std::vector<VkDrawIndexedIndirectCommand>& commands) {
+    if (commands.empty()) return;
+
+    // the frame has finished with its buffer, so it can be replaced straight away
+    IndirectBuffer& indirectBuffer = indirectBuffers[frame];
+    const uint32_t commandCount = static_cast<uint32_t>(commands.size());
+    if (indirectBuffer.capacity < commandCount) {
+        createIndirectBuffer(indirectBuffer, commandCount);
+    }
+    std::memcpy(indirectBuffer.mapped, commands.data(), sizeof(VkDrawIndexedIndirectCommand) * commands.size());
+
+    // without multi draw indirect each call reads a single command
+    constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    for (uint32_t first = 0; first < commandCount; first += maxDrawIndirectCount) {
+        const uint32_t drawCount = std::min(maxDrawIndirectCount, commandCount - first);
+        vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer.buffer->getBuffer(), static_cast<VkDeviceSize>(first) * stride, drawCount, stride);
+    }
+}
+
+const VkBuffer GeometryBuffer::getVertexBuffer() const {
+    return vertexBuffer->getBuffer();
+}
+
+const VkBuffer GeometryBuffer::getIndexBuffer() const {
+    return indexBuffer->getBuffer();
+}
+
+void GeometryBuffer::createIndirectBuffer(IndirectBuffer& indirectBuffer, uint32_t capacity) {
+    // kept mapped like the uniform buffers, written by the CPU as each frame is recorded
+    indirectBuffer.buffer = std::make_unique<Buffer>(device, physicalDevice, sizeof(VkDrawIndexedIndirectCommand) * static_cast<VkDeviceSize>(capacity),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    indirectBuffer.buffer->mapMemory(&indirectBuffer.mapped);
+    indirectBuffer.capacity = capacity;
+}
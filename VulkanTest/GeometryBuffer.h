@@ -0,0 +1,95 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "RangeAllocator.h"
+#include <memory>
+#include <vector>
+
+class LogicalDevice;
+class PhysicalDevice;
+class CommandPool;
+class Buffer;
+
+/// <summary>
+/// Where a mesh's vertices and indices were placed in the GeometryBuffer
+/// </summary>
+struct GeometryAllocation {
+	uint32_t firstVertex = 0;
+	uint32_t vertexCount = 0;
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+};
+
+/// <summary>
+/// Shared vertex and index buffers every static mesh is placed in, so a frame binds its geometry once and each mesh
+/// is drawn by its first index and vertex offset, many of them in one call with multi draw indirect
+/// </summary>
+class GeometryBuffer {
+public:
+	/// <param name="vertexStride">Size of each vertex in bytes</param>
+	/// <param name="vertexCapacity">Vertices the vertex buffer holds</param>
+	/// <param name="indexCapacity">16 bit indices the index buffer holds</param>
+	GeometryBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity);
+	~GeometryBuffer();
+
+	/// <summary>
+	/// Reserves room for a mesh, throwing if either buffer is too full
+	/// </summary>
+	GeometryAllocation allocate(uint32_t vertexCount, uint32_t indexCount);
+
+	/// <summary>
+	/// Frees a mesh's room, only once no frame in flight can still draw it
+	/// </summary>
+	void free(const GeometryAllocation& allocation);
+
+	/// <summary>
+	/// Copies staged vertices and indices into the allocation's ranges
+	/// </summary>
+	void upload(const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const GeometryAllocation& allocation,
+				const std::unique_ptr<Buffer>& vertices, const std::unique_ptr<Buffer>& indices);
+
+	/// <summary>
+	/// Binds the vertex buffer to binding 0 and the index buffer, once for every mesh drawn after
+	/// </summary>
+	void bind(VkCommandBuffer commandBuffer) const;
+
+	/// <summary>
+	/// Draws the commands from the frame's indirect buffer, in one call where the device supports multi draw indirect.
+	/// Call once per frame, after the frame's fence has been waited on as its indirect buffer is rewritten
+	/// </summary>
+	void drawIndirect(VkCommandBuffer commandBuffer, uint32_t frame, const std::vector<VkDrawIndexedIndirectCommand>& commands);
+
+	const VkBuffer getVertexBuffer() const;
+	const VkBuffer getIndexBuffer() const;
+
+private:
+	struct IndirectBuffer {
+		std::unique_ptr<Buffer> buffer;
+		void* mapped = nullptr;
+		uint32_t capacity = 0;
+	};
+
+	/// <summary>
+	/// Replaces the frame's indirect buffer with one holding capacity commands
+	/// </summary>
+	void createIndirectBuffer(IndirectBuffer& indirectBuffer, uint32_t capacity);
+
+private:
+	std::unique_ptr<Buffer> vertexBuffer;
+	std::unique_ptr<Buffer> indexBuffer;
+	RangeAllocator vertexAllocator;
+	RangeAllocator indexAllocator;
+	uint32_t vertexStride;
+
+	/// <summary>
+	/// Commands one indirect draw can read, 1 without multi draw indirect
+	/// </summary>
+	uint32_t maxDrawIndirectCount;
+
+	/// <summary>
+	/// Host visible draw commands for each frame in flight
+	/// </summary>
+	std::vector<IndirectBuffer> indirectBuffers;
+
+	const std::unique_ptr<LogicalDevice>& device;
+	const std::unique_ptr<PhysicalDevice>& physicalDevice;
+};
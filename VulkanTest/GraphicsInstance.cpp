@@ -10,7 +10,7 @@ GraphicsInstance::GraphicsInstance(const std::unique_ptr<Window>& window) {
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_1; // for vkGetPhysicalDeviceFeatures2
 
     // INSTANCE CREATE INFO
     VkInstanceCreateInfo createInfo{};
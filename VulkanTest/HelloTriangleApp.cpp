@@ -10,11 +10,100 @@
 #include "Image.h"
 #include "CommandPool.h"
 #include "Texture.h"
+#include "ThreadPool.h"
+#include "AssetPack.h"
 #include "Buffer.h"
 #include "Model.h"
+#include "PipelineCache.h"
+#include "PipelineManager.h"
+#include "DynamicState.h"
+#include "InstanceBuffer.h"
+#include "GeometryBuffer.h"
 
 #include "Debug.h"
 
+#include <algorithm>
+#include <array>
+#include <filesystem>
+
+namespace {
+    /// <summary>
+    /// Barrier moving a whole attachment between layouts, the render pass did these itself
+    /// </summary>
+    VkImageMemoryBarrier attachmentBarrier(VkImage image, VkImageAspectFlags aspectMask, VkImageLayout oldLayout, VkImageLayout newLayout,
+                                           VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = aspectMask;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = srcAccessMask;
+        barrier.dstAccessMask = dstAccessMask;
+        return barrier;
+    }
+
+    /// <summary>
+    /// The model's pipeline, its vertex input derived from Vertex's and InstanceData's fields and hashed while compiling
+    /// </summary>
+    constexpr PipelineDescription BASE_PIPELINE = [] {
+        PipelineDescription description;
+        description.setShaders("shaders/vert.spv", "shaders/frag.spv")
+            .addVertexLayout<Vertex>(0)
+            .addVertexLayout<InstanceData>(1, VK_VERTEX_INPUT_RATE_INSTANCE);
+        return description;
+    }();
+    constexpr uint64_t BASE_PIPELINE_HASH = BASE_PIPELINE.hash();
+
+    /// <summary>
+    /// Distance between neighbouring instances in the grid
+    /// </summary>
+    constexpr float INSTANCE_SPACING = 2.5f;
+
+    /// <summary>
+    /// Each material's variant of the base pipeline, in the order of HelloTriangleApp::Material, then single and double sided
+    /// </summary>
+    constexpr std::array<std::array<PipelineDescription, 2>, 3> MATERIAL_PIPELINES = [] {
+        std::array<PipelineDescription, 3> materials = { BASE_PIPELINE, BASE_PIPELINE, BASE_PIPELINE };
+        materials[1].fragmentConstants.set(FRAGMENT_USE_TEXTURE, false);
+        materials[2].fragmentConstants.set(FRAGMENT_ALPHA_TEST, true).set(FRAGMENT_ALPHA_CUTOFF, 0.5f);
+
+        std::array<std::array<PipelineDescription, 2>, 3> pipelines{};
+        for (size_t i = 0; i < materials.size(); i++) {
+            pipelines[i] = { materials[i], materials[i] };
+            pipelines[i][1].cullMode = VK_CULL_MODE_NONE;
+        }
+        return pipelines;
+    }();
+
+    /// <summary>
+    /// Hash of each of MATERIAL_PIPELINES, so requesting one never hashes its description at run time
+    /// </summary>
+    constexpr std::array<std::array<uint64_t, 2>, 3> MATERIAL_PIPELINE_HASHES = [] {
+        std::array<std::array<uint64_t, 2>, 3> hashes{};
+        for (size_t i = 0; i < MATERIAL_PIPELINES.size(); i++) {
+            for (size_t j = 0; j < MATERIAL_PIPELINES[i].size(); j++) {
+                hashes[i][j] = MATERIAL_PIPELINES[i][j].hash();
+            }
+        }
+        return hashes;
+    }();
+    static_assert([] {
+        for (size_t i = 0; i < 6; i++) {
+            for (size_t j = i + 1; j < 6; j++) {
+                if (MATERIAL_PIPELINE_HASHES[i / 2][i % 2] == MATERIAL_PIPELINE_HASHES[j / 2][j % 2]) return false;
+            }
+        }
+        return true;
+    }(), "material pipelines must hash differently");
+}
+
 HelloTriangleApp::HelloTriangleApp() {
     window = std::make_unique<Window>();
 
@@ -64,10 +153,20 @@ void HelloTriangleApp::initIMGUI() {
     initInfo.Device = device->getDevice();
     initInfo.QueueFamily = physicalDevice->getQueueFamilyIndices().graphicsFamily.value();
     initInfo.Queue = queues.graphics;
-    initInfo.PipelineCache = VK_NULL_HANDLE; // optional
+    initInfo.PipelineCache = pipelineCache->getPipelineCache();
     initInfo.DescriptorPool = imguiDescriptorPool;
     initInfo.RenderPass = renderPass;
     initInfo.Subpass = 0; // optional
+
+    // without a render pass imgui's pipeline is given the attachments' formats, only read while initialising
+    const VkFormat colorFormat = swapchain->getFormat();
+    if (renderPass == VK_NULL_HANDLE) {
+        initInfo.UseDynamicRendering = true;
+        initInfo.PipelineRenderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+        initInfo.PipelineRenderingCreateInfo.colorAttachmentCount = 1;
+        initInfo.PipelineRenderingCreateInfo.pColorAttachmentFormats = &colorFormat;
+        initInfo.PipelineRenderingCreateInfo.depthAttachmentFormat = swapchain->getDepthFormat();
+    }
     initInfo.MinImageCount = MAX_FRAMES_IN_FLIGHT;
     initInfo.ImageCount = MAX_FRAMES_IN_FLIGHT;
     initInfo.MSAASamples = physicalDevice->getSampleCount();
@@ -75,7 +174,8 @@ void HelloTriangleApp::initIMGUI() {
     initInfo.CheckVkResultFn = Debug::checkVkResult;
     ImGui_ImplVulkan_Init(&initInfo);
 
-    texDS = ImGui_ImplVulkan_AddTexture(textureSampler, texture->getImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    texDSImageView = assetLoader->getTexture(textureHandle)->getImageView();
+    texDS = ImGui_ImplVulkan_AddTexture(textureSampler, texDSImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
 
 void HelloTriangleApp::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
@@ -89,26 +189,12 @@ void HelloTriangleApp::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32
 
     const VkExtent2D swapchainExtent = swapchain->getExtent();
 
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = renderPass;                                 // applicable render pass
-    renderPassInfo.framebuffer = swapchain->getFrameBuffer(imageIndex);     // relevant swapchain framebuffer to use in fragment shader
-    renderPassInfo.renderArea.offset = { 0, 0 };                            // the area rendering takes place
-    renderPassInfo.renderArea.extent = swapchainExtent;                     // (usually size of attachment aka framebuffer)
-
-    std::array<VkClearValue, 2> clearValues{};
-    // set the clear value of the render pass info to black
-    clearValues[0].color = {{clearColor.x, clearColor.y, clearColor.z, clearColor.w}};
-    clearValues[1].depthStencil = { 1.0f, 0 };
+    // begin rendering to the swapchain image to begin drawing
+    beginRendering(commandBuffer, imageIndex);
 
-    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassInfo.pClearValues = clearValues.data();
-
-    // begin the remder pass to begin drawing
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    // bind to the graphics pipeline to declare what operations to execute in the graphics pipeline
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    // bind to the graphics pipeline to declare what operations to execute in the graphics pipeline,
+    // along with the variant's cull mode, depth and topology where they're dynamic
+    pipelineManager->bind(commandBuffer, activePipeline);
 
     // as they are set to dynamic and we are not recreating graphics pipeline when
     // framebuffer is resized we have to set viewport and scissor state here
@@ -130,14 +216,29 @@ void HelloTriangleApp::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32
 
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
 
-    model->draw(commandBuffer);
+    // lod selection works in the model's space, so bring the camera into it. Every instance shares the lod, so it's picked for the nearest
+    const glm::vec3 modelCameraPosition = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(cameraPosition, 1.0f));
+    const std::vector<InstanceData>& instances = instanceBuffer->getInstances();
+    const auto nearest = std::min_element(instances.begin(), instances.end(), [&](const InstanceData& a, const InstanceData& b) {
+        return glm::distance(glm::vec3(a.model[3]), modelCameraPosition) < glm::distance(glm::vec3(b.model[3]), modelCameraPosition);
+    });
+    const glm::vec3 instanceCameraPosition = glm::vec3(glm::inverse(nearest->model) * glm::vec4(modelCameraPosition, 1.0f));
+    const float projectionScale = swapchainExtent.height / (2.0f * std::tan(fieldOfView * 0.5f));
+
+    // every model's geometry is bound once at binding 0, then all the frame's draws are made from the indirect buffer
+    geometryBuffer->bind(commandBuffer);
+    instanceBuffer->bind(commandBuffer, currentFrame, 1);
+
+    drawCommands.clear();
+    assetLoader->getModel(modelHandle)->addDrawCommands(drawCommands, instanceCameraPosition, projectionScale, instanceBuffer->getInstanceCount());
+    geometryBuffer->drawIndirect(commandBuffer, currentFrame, drawCommands);
 
     // render the imgui
     ImGui::Render();
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
 
-    // drawing is finished to end the render pass
-    vkCmdEndRenderPass(commandBuffer);
+    // drawing is finished so end rendering
+    endRendering(commandBuffer, imageIndex);
 
     // finished recording commands so end command buffer recording
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
@@ -145,10 +246,112 @@ void HelloTriangleApp::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32
     }
 }
 
+void HelloTriangleApp::beginRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+    const VkExtent2D swapchainExtent = swapchain->getExtent();
+
+    std::array<VkClearValue, 2> clearValues{};
+    // set the clear value of the render pass info to black
+    clearValues[0].color = {{clearColor.x, clearColor.y, clearColor.z, clearColor.w}};
+    clearValues[1].depthStencil = { 1.0f, 0 };
+
+    if (renderPass != VK_NULL_HANDLE) {
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;                                 // applicable render pass
+        renderPassInfo.framebuffer = swapchain->getFrameBuffer(imageIndex);     // relevant swapchain framebuffer to use in fragment shader
+        renderPassInfo.renderArea.offset = { 0, 0 };                            // the area rendering takes place
+        renderPassInfo.renderArea.extent = swapchainExtent;                     // (usually size of attachment aka framebuffer)
+
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data();
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        return;
+    }
+
+    // every attachment is cleared so none keep their contents, but the last frame's writes to them must finish first
+    VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (Image::hasStencilComponent(swapchain->getDepthFormat())) {
+        depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    const std::array<VkImageMemoryBarrier, 3> barriers = {
+        attachmentBarrier(swapchain->getImage(imageIndex), VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT),
+        attachmentBarrier(swapchain->getColorImage(), VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT),
+        attachmentBarrier(swapchain->getDepthImage(), depthAspect, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT)
+    };
+
+    vkCmdPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+        0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    // the multisampled image is resolved into the swapchain image, so only the swapchain image is stored
+    VkRenderingAttachmentInfoKHR colorAttachment{};
+    colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.clearValue = clearValues[0];
+    if (physicalDevice->getSampleCount() != VK_SAMPLE_COUNT_1_BIT) {
+        colorAttachment.imageView = swapchain->getColorImageView();
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+        colorAttachment.resolveImageView = swapchain->getImageView(imageIndex);
+        colorAttachment.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    } else {
+        colorAttachment.imageView = swapchain->getImageView(imageIndex);
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    }
+
+    VkRenderingAttachmentInfoKHR depthAttachment{};
+    depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    depthAttachment.imageView = swapchain->getDepthImageView();
+    depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.clearValue = clearValues[1];
+
+    VkRenderingInfoKHR renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    renderingInfo.renderArea.offset = { 0, 0 };
+    renderingInfo.renderArea.extent = swapchainExtent;
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachments = &colorAttachment;
+    renderingInfo.pDepthAttachment = &depthAttachment;
+
+    vkCmdBeginRenderingKHR(commandBuffer, &renderingInfo);
+}
+
+void HelloTriangleApp::endRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+    // the render pass's final layout leaves the image ready to present
+    if (renderPass != VK_NULL_HANDLE) {
+        vkCmdEndRenderPass(commandBuffer);
+        return;
+    }
+
+    vkCmdEndRenderingKHR(commandBuffer);
+
+    const VkImageMemoryBarrier barrier = attachmentBarrier(swapchain->getImage(imageIndex), VK_IMAGE_ASPECT_COLOR_BIT,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0);
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
 void HelloTriangleApp::drawFrame() {
     // ensure frame we are drawing has finished on the GPU side
     vkWaitForFences(device->getDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
 
+    // frame boundary, main thread jobs swap in any assets that finished loading then this frame's descriptors are pointed at them
+    threadPool->runMainThreadJobs();
+    assetLoader->update();
+    updateTextureBindings(currentFrame);
+    instanceBuffer->update(currentFrame);
+
     // async acquire image from the GPU swap chain, but returns index of image straight away
     uint32_t imageIndex;
     VkResult result = vkAcquireNextImageKHR(device->getDevice(), swapchain->getSwapchain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
@@ -164,13 +367,14 @@ void HelloTriangleApp::drawFrame() {
     // reset fence ready for the queue submit call, done here as if statement may return early
     vkResetFences(device->getDevice(), 1, &inFlightFences[currentFrame]);
 
+    // update before recording as the model matrix is also used to pick the level of detail
+    updateUniformBuffer(currentFrame);
+
     // reset the command buffer then record the new commands we want
     // with the imageIndex telling the command buffer what framebuffer of the GPU has been acquired
     vkResetCommandBuffer(commandBuffers[currentFrame], 0);
     recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
 
-    updateUniformBuffer(currentFrame);
-
     // info about command buffer submission
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -237,13 +441,72 @@ void HelloTriangleApp::updateUniformBuffer(uint32_t currentImage) {
         ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     }
 
-    ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.proj = glm::perspective(glm::radians(45.0f), swapchain->getAspectRatio(), 0.1f, 10.0f);
+    modelMatrix = ubo.model;
+
+    ubo.view = glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    ubo.proj = glm::perspective(fieldOfView, swapchain->getAspectRatio(), 0.1f, 10.0f);
     ubo.proj[1][1] *= -1; // glm designed for opengl so flip Y
 
     std::memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
 }
 
+void HelloTriangleApp::updateInstances() {
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(instanceCount))));
+    const float centre = (side - 1) * 0.5f;
+
+    std::vector<InstanceData> instances(instanceCount);
+    for (int i = 0; i < instanceCount; i++) {
+        const int x = i % side;
+        const int y = i / side;
+
+        InstanceData& instance = instances[i];
+        instance.model = glm::translate(glm::mat4(1.0f), glm::vec3((x - centre) * INSTANCE_SPACING, (y - centre) * INSTANCE_SPACING, 0.0f));
+
+        // tinted across the grid so the copies can be told apart, a lone instance is left untinted
+        instance.color = glm::vec4(0.5f + 0.5f * (x + 1) / side, 0.5f + 0.5f * (y + 1) / side, 1.0f, 1.0f);
+    }
+
+    instanceBuffer->setInstances(std::move(instances));
+}
+
+void HelloTriangleApp::updateTextureBindings(uint32_t frame) {
+    // old imgui descriptor sets are removed once every frame that could have drawn with them has finished
+    for (auto retired = retiredTexDS.begin(); retired != retiredTexDS.end();) {
+        if (--retired->second == 0) {
+            ImGui_ImplVulkan_RemoveTexture(retired->first);
+            retired = retiredTexDS.erase(retired);
+        } else {
+            retired++;
+        }
+    }
+
+    VkImageView imageView = assetLoader->getTexture(textureHandle)->getImageView();
+    if (texDSImageView != imageView) {
+        retiredTexDS.emplace_back(texDS, MAX_FRAMES_IN_FLIGHT);
+        texDSImageView = imageView;
+        texDS = ImGui_ImplVulkan_AddTexture(textureSampler, texDSImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+
+    if (boundImageViews[frame] == imageView) return;
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = imageView;
+    imageInfo.sampler = textureSampler;
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSets[frame];
+    descriptorWrite.dstBinding = 1;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device->getDevice(), 1, &descriptorWrite, 0, nullptr);
+    boundImageViews[frame] = imageView;
+}
+
 void HelloTriangleApp::createRenderPass() {
     VkAttachmentDescription colorAttachment{};
     colorAttachment.format = swapchain->getFormat();
@@ -346,99 +609,6 @@ void HelloTriangleApp::createDescriptorSetLayout() {
 }
 
 void HelloTriangleApp::createGraphicsPipeline() {
-    // read compiled shaders
-    auto vertShaderCode = readFile("shaders/vert.spv");
-    auto fragShaderCode = readFile("shaders/frag.spv");
-
-    // create modules from compiled code
-    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
-
-    // create info for both shaders
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-    // dynamic state
-    std::vector<VkDynamicState> dynamicStates = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
-
-    VkPipelineDynamicStateCreateInfo dynamicState{};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-    dynamicState.pDynamicStates = dynamicStates.data();
-
-    // vertex input
-    auto bindingDesc = Vertex::getBindingDescription();
-    auto attributeDescs = Vertex::getAttributeDescriptions();
-
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescs.size());
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDesc;
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescs.data();
-
-    // input type
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    // viewport state (0 cause dynamic)
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.scissorCount = 1;
-
-    // rasterizer
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-
-    // multisampling
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = physicalDevice->getSampleCount();
-
-    // blending
-    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_FALSE;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-
-    VkPipelineDepthStencilStateCreateInfo depthStencil{};
-    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = VK_TRUE;
-    depthStencil.depthWriteEnable = VK_TRUE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-    depthStencil.depthBoundsTestEnable = VK_FALSE; // Limit the depth range to keep fragments
-    depthStencil.stencilTestEnable = VK_FALSE; // stencil testing with stencil buffer
-
     // pipeline layout
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -449,32 +619,28 @@ void HelloTriangleApp::createGraphicsPipeline() {
         Debug::exception("failed to create pipeline layout");
     }
 
-    // CREATE PIPELINE
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStages;
-
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = &dynamicState;
-    pipelineInfo.pDepthStencilState = &depthStencil;
-    
-    pipelineInfo.layout = pipelineLayout;
-    pipelineInfo.renderPass = renderPass;
-    pipelineInfo.subpass = 0;
+    pipelineManager = std::make_unique<PipelineManager>(*threadPool, device, pipelineCache, dynamicState);
 
-    if (vkCreateGraphicsPipelines(device->getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-        Debug::exception("failed to create graphics pipeline");
-    }
+    PipelineKey& key = pipelineKey;
+    key.setDescription(BASE_PIPELINE, BASE_PIPELINE_HASH);
+    key.samples = physicalDevice->getSampleCount();
+    key.layout = pipelineLayout;
+    key.renderPass = renderPass;
+    key.colorFormat = swapchain->getFormat();
+    key.depthFormat = swapchain->getDepthFormat();
+
+    // the first frame needs a pipeline, variants compile in the background and draw with it until they're ready
+    graphicsPipeline = pipelineManager->create(key);
+    activePipeline = graphicsPipeline;
+}
+
+void HelloTriangleApp::requestPipeline() {
+    PipelineKey key = pipelineKey;
+    const size_t variant = static_cast<size_t>(material);
+    const size_t sides = renderDoubleSided ? 1 : 0;
+    key.setDescription(MATERIAL_PIPELINES[variant][sides], MATERIAL_PIPELINE_HASHES[variant][sides]);
 
-    // destroy used shaders
-    vkDestroyShaderModule(device->getDevice(), fragShaderModule, nullptr);
-    vkDestroyShaderModule(device->getDevice(), vertShaderModule, nullptr);
+    activePipeline = pipelineManager->request(key, graphicsPipeline);
 }
 
 void HelloTriangleApp::createTextureSampler() {
@@ -497,7 +663,7 @@ void HelloTriangleApp::createTextureSampler() {
     createInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     createInfo.mipLodBias = 0.0f;
     createInfo.minLod = 0.0f;
-    createInfo.maxLod = static_cast<float>(texture->getMipLevels());
+    createInfo.maxLod = VK_LOD_CLAMP_NONE; // textures are swapped in after the sampler is made so don't limit it to one's mip count
 
     if (vkCreateSampler(device->getDevice(), &createInfo, nullptr, &textureSampler) != VK_SUCCESS) {
         Debug::exception("failed to create sampler");
@@ -521,14 +687,16 @@ void HelloTriangleApp::createDescriptorPool() {
         Debug::exception("failed to create descriptor pool");
     }
 
+    // the font, the texture window's current set, and the sets retired by updateTextureBindings until their frames finish
+    const uint32_t imguiSetCount = static_cast<uint32_t>(2 + MAX_FRAMES_IN_FLIGHT);
     VkDescriptorPoolSize pool_sizes[] =
     {
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imguiSetCount },
     };
     VkDescriptorPoolCreateInfo pool_info = {};
     pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-    pool_info.maxSets = 2;
+    pool_info.maxSets = imguiSetCount;
     pool_info.poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes);
     pool_info.pPoolSizes = pool_sizes;
     vkCreateDescriptorPool(device->getDevice(), &pool_info, nullptr, &imguiDescriptorPool);
@@ -544,6 +712,7 @@ void HelloTriangleApp::createDescriptorSets() {
     allocInfo.pSetLayouts = layouts.data();
 
     descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+    boundImageViews.resize(MAX_FRAMES_IN_FLIGHT);
     if (vkAllocateDescriptorSets(device->getDevice(), &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
         Debug::exception("failed to allocate descriptor sets");
     }
@@ -556,8 +725,9 @@ void HelloTriangleApp::createDescriptorSets() {
 
         VkDescriptorImageInfo imageInfo{};
         imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = texture->getImageView();
+        imageInfo.imageView = assetLoader->getTexture(textureHandle)->getImageView();
         imageInfo.sampler = textureSampler;
+        boundImageViews[i] = imageInfo.imageView;
 
         std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
         descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -610,6 +780,8 @@ void HelloTriangleApp::initVulkan() {
     physicalDevice = std::make_unique<PhysicalDevice>(instance, surface);
     device = std::make_unique<LogicalDevice>(physicalDevice);
     queues = device->getQueueHandles(physicalDevice->getQueueFamilyIndices());
+    pipelineCache = std::make_unique<PipelineCache>(device, physicalDevice, PIPELINE_CACHE_PATH);
+    dynamicState = std::make_unique<DynamicState>(device, physicalDevice);
 
     // command pools
     QueueFamilyIndices indices = physicalDevice->getQueueFamilyIndices();
@@ -623,7 +795,21 @@ void HelloTriangleApp::initVulkan() {
     VkExtent2D surfaceExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
     swapchain = std::make_unique<Swapchain>(device, physicalDevice, surface, surfaceExtent);
 
-    createRenderPass();
+    // the AssetCooker packs the cooked assets at build time, without a pack everything is read from loose files
+    threadPool = std::make_unique<ThreadPool>();
+    if (std::filesystem::exists(PACK_PATH)) {
+        assetPack = std::make_unique<AssetPack>(PACK_PATH);
+    } else {
+        Debug::log("no asset pack, run the AssetCooker to build one. Reading loose files instead");
+    }
+
+    // dynamic rendering needs no render pass, and so no framebuffers to rebuild when the swapchain is
+    if (physicalDevice->getDynamicRenderingSupport()) {
+        vkCmdBeginRenderingKHR = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(device->getDevice(), "vkCmdBeginRenderingKHR"));
+        vkCmdEndRenderingKHR = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(device->getDevice(), "vkCmdEndRenderingKHR"));
+    } else {
+        createRenderPass();
+    }
     createDescriptorSetLayout();
     createGraphicsPipeline();
     
@@ -634,11 +820,13 @@ void HelloTriangleApp::initVulkan() {
     vkGetPhysicalDeviceFormatProperties(physicalDevice->getPhysicalDevice(), Texture::imageFormat, &formatProps);
     Texture::setFormatProperties(formatProps);
 
-    texture = std::make_unique<Texture>(device, physicalDevice, commandPool, transferCommandPool, TEXTURE_PATH);
+    // assets load on the workers so the first frame doesn't wait for them, their geometry uploaded into the shared buffers
+    geometryBuffer = std::make_unique<GeometryBuffer>(device, physicalDevice, static_cast<uint32_t>(sizeof(Vertex)), GEOMETRY_VERTEX_CAPACITY, GEOMETRY_INDEX_CAPACITY);
+    assetLoader = std::make_unique<AssetLoader>(*threadPool, assetPack, device, physicalDevice, commandPool, transferCommandPool, geometryBuffer);
+    modelHandle = assetLoader->loadModel(MODEL_PATH);
+    textureHandle = assetLoader->loadTexture(TEXTURE_PATH);
 
     createTextureSampler();
-
-    model = std::make_unique<Model>(device, physicalDevice, commandPool, transferCommandPool, MODEL_PATH);
     
     VkDeviceSize uniformBufferSize = sizeof(UniformBufferObject);
     uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
@@ -649,6 +837,9 @@ void HelloTriangleApp::initVulkan() {
         uniformBuffers[i]->mapMemory(&uniformBuffersMapped[i]);
     }
 
+    instanceBuffer = std::make_unique<InstanceBuffer>(device, physicalDevice, static_cast<uint32_t>(instanceCount));
+    updateInstances();
+
     createDescriptorPool();
     createDescriptorSets();
     commandBuffers = commandPool->createCommandBuffers(MAX_FRAMES_IN_FLIGHT);
@@ -698,6 +889,21 @@ void HelloTriangleApp::drawImgui() {
         ImGui::Checkbox("Demo Window", &showDemoWindow);      // Edit bools storing our window open/close state
         ImGui::Checkbox("Render Static", &renderStatic);
 
+        // each combination is its own pipeline, compiled the first time it's picked
+        bool pipelineChanged = ImGui::Checkbox("Double Sided", &renderDoubleSided);
+        const char* materialNames[] = { "Textured", "Vertex Color", "Alpha Tested" };
+        int materialIndex = static_cast<int>(material);
+        if (ImGui::Combo("Material", &materialIndex, materialNames, IM_ARRAYSIZE(materialNames))) {
+            material = static_cast<Material>(materialIndex);
+            pipelineChanged = true;
+        }
+        if (pipelineChanged) requestPipeline();
+
+        // every copy is drawn by the same call, only the instance buffer grows
+        if (ImGui::SliderInt("Instances", &instanceCount, 1, MAX_INSTANCES)) {
+            updateInstances();
+        }
+
         ImGui::SliderFloat("float", &f, 0.0f, 1.0f);            // Edit 1 float using a slider from 0.0f to 1.0f
         ImGui::ColorEdit3("clear color", (float*)&clearColor); // Edit 3 floats representing a color
 
@@ -714,12 +920,20 @@ void HelloTriangleApp::drawImgui() {
 }
 
 void HelloTriangleApp::cleanup() {
+    // after both imgui's and our pipelines were created, so the next run has all of them.
+    // Material variants still compiling on the pool would be left out, so they are finished first
+    pipelineManager->waitForCompiles();
+    pipelineCache->save();
+
     cleanupImgui();
     cleanupVulkan();
 }
 
 void HelloTriangleApp::cleanupImgui() {
     ImGui_ImplVulkan_RemoveTexture(texDS);
+    for (const auto& [retired, framesLeft] : retiredTexDS) {
+        ImGui_ImplVulkan_RemoveTexture(retired);
+    }
 
     ImGui_ImplVulkan_Shutdown();
     window->imguiShutdown();
@@ -739,38 +953,7 @@ void HelloTriangleApp::cleanupVulkan() {
         vkDestroyFence(device->getDevice(), inFlightFences[i], nullptr);
     }
 
-    vkDestroyPipeline(device->getDevice(), graphicsPipeline, nullptr);
+    pipelineManager.reset();
     vkDestroyPipelineLayout(device->getDevice(), pipelineLayout, nullptr);
     vkDestroyRenderPass(device->getDevice(), renderPass, nullptr);
 }
-
-VkShaderModule HelloTriangleApp::createShaderModule(const std::vector<char>& code) const {
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-    VkShaderModule shaderModule;
-    if (vkCreateShaderModule(device->getDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-        Debug::exception("failed to create shader module");
-    }
-
-    return shaderModule;
-}
-
-std::vector<char> HelloTriangleApp::readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open()) {
-        Debug::exception("failed to open file");
-    }
-
-    size_t fileSize = (size_t)file.tellg();
-    std::vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-    file.close();
-
-    return buffer;
-}
\ No newline at end of file
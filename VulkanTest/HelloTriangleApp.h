@@ -8,6 +8,8 @@
 
 #include "Queues.h"
 #include "Structures.h"
+#include "AssetLoader.h"
+#include "PipelineManager.h"
 
 class GraphicsInstance;
 class Window;
@@ -19,6 +21,12 @@ class CommandPool;
 class Texture;
 class Buffer;
 class Model;
+class ThreadPool;
+class AssetPack;
+class PipelineCache;
+class DynamicState;
+class InstanceBuffer;
+class GeometryBuffer;
 
 class HelloTriangleApp {
 public: //                         PUBLIC FUNCTIONS
@@ -36,6 +44,16 @@ private: //                         PRIVATE VARIABLES
     std::unique_ptr<LogicalDevice> device;
     Queues queues;
 
+    /// <summary>
+    /// Loaded from disk at startup and saved on shutdown, so warm starts skip compiling pipelines
+    /// </summary>
+    std::unique_ptr<PipelineCache> pipelineCache;
+
+    /// <summary>
+    /// Pipeline state set while recording where the device supports it, so variants only differing in it share a pipeline
+    /// </summary>
+    std::unique_ptr<DynamicState> dynamicState;
+
     /// <summary>
     /// Responsible for temporary transfer command buffers
     /// </summary>
@@ -49,15 +67,52 @@ private: //                         PRIVATE VARIABLES
     
     std::unique_ptr<Swapchain> swapchain;
 
-    std::unique_ptr<Texture> texture;
+    /// <summary>
+    /// Job system for CPU heavy work such as loading assets, its main thread jobs are run on each frame boundary
+    /// </summary>
+    std::unique_ptr<ThreadPool> threadPool;
+
+    /// <summary>
+    /// Assets packed by the AssetCooker, null if it hasn't built a pack in which case loose files are read instead
+    /// </summary>
+    std::unique_ptr<AssetPack> assetPack;
+
+    /// <summary>
+    /// Vertices and indices of every model, bound once a frame. Destroyed after the loader, as its models free their room in it
+    /// </summary>
+    std::unique_ptr<GeometryBuffer> geometryBuffer;
+
+    /// <summary>
+    /// Draws of the frame being recorded, kept to reuse its memory, see GeometryBuffer::drawIndirect
+    /// </summary>
+    std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+
+    /// <summary>
+    /// Loads the model and texture in the background, placeholders are drawn until they're uploaded
+    /// </summary>
+    std::unique_ptr<AssetLoader> assetLoader;
+    ModelHandle modelHandle;
+    TextureHandle textureHandle;
+
+    /// <summary>
+    /// Texture image view each frame's descriptor set was last written with
+    /// </summary>
+    std::vector<VkImageView> boundImageViews;
 
     /// <summary>
     /// Render pass encapsulates the state needed for renderering to the target, for example: 
     /// what buffers will be in the framebuffer rendered to;
     /// how many samples to use for each buffer;
-    /// how the contents of the buffer should be handled during rendering
+    /// how the contents of the buffer should be handled during rendering.
+    /// Null where the device supports dynamic rendering, which is given the attachments as it begins instead
+    /// </summary>
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+
+    /// <summary>
+    /// Dynamic rendering's commands, loaded from the device as they're from an extension
     /// </summary>
-    VkRenderPass renderPass;
+    PFN_vkCmdBeginRenderingKHR vkCmdBeginRenderingKHR = nullptr;
+    PFN_vkCmdEndRenderingKHR vkCmdEndRenderingKHR = nullptr;
     
     /// <summary>
     /// Describes layout of things to be passed to the shader
@@ -70,9 +125,30 @@ private: //                         PRIVATE VARIABLES
     VkPipelineLayout pipelineLayout;
 
     /// <summary>
-    /// Representation of the entire graphics pipeline, both fixed function and programmable parts in the form of shaders
+    /// Compiles the graphics pipelines, each a representation of the entire pipeline, both fixed function and programmable parts in the form of shaders
     /// </summary>
-    VkPipeline graphicsPipeline;    
+    std::unique_ptr<PipelineManager> pipelineManager;
+
+    /// <summary>
+    /// State of the graphics pipeline, copied and changed for each variant
+    /// </summary>
+    PipelineKey pipelineKey;
+
+    /// <summary>
+    /// Ids of the pipelines in the pipeline manager, the active variant draws with the graphics pipeline until it has compiled
+    /// </summary>
+    uint32_t graphicsPipeline;
+    uint32_t activePipeline;
+
+    /// <summary>
+    /// Variants of shader.frag, picked with its specialization constants
+    /// </summary>
+    enum class Material {
+        Textured,
+        VertexColor,
+        AlphaTested
+    };
+    Material material = Material::Textured;
 
     /// <summary>
     /// The current frame to be rendered by the GPU, will be from [0, MAX_FRAMES_IN_FLIGHT)
@@ -94,9 +170,7 @@ private: //                         PRIVATE VARIABLES
     /// </summary>
     std::vector<VkFence> inFlightFences;
 
-    // can use same buffer for both indices and vertices
     VkSampler textureSampler;
-    std::unique_ptr<Model> model;
 
     VkDescriptorPool descriptorPool;
     std::vector<VkDescriptorSet> descriptorSets;
@@ -104,6 +178,21 @@ private: //                         PRIVATE VARIABLES
     std::vector<std::unique_ptr<Buffer>> uniformBuffers;
     std::vector<void*> uniformBuffersMapped;
 
+    /// <summary>
+    /// Transform and colour of each copy of the model, every copy drawn in one call
+    /// </summary>
+    std::unique_ptr<InstanceBuffer> instanceBuffer;
+    int instanceCount = 1;
+
+    // CAMERA
+    glm::vec3 cameraPosition = glm::vec3(2.0f, 2.0f, 2.0f);
+    float fieldOfView = glm::radians(45.0f);
+
+    /// <summary>
+    /// Model matrix of the current frame, kept from updating the uniform buffer for level of detail selection
+    /// </summary>
+    glm::mat4 modelMatrix = glm::mat4(1.0f);
+
     // IMGUI
     VkDescriptorPool imguiDescriptorPool;
     ImGuiIO* io;
@@ -111,7 +200,14 @@ private: //                         PRIVATE VARIABLES
     ImVec4 clearColor = ImVec4(0.0f, 0.00f, 0.00f, 1.00f);
     bool showDemoWindow = false;
     bool renderStatic = false;
+    bool renderDoubleSided = false;
     VkDescriptorSet texDS;
+    VkImageView texDSImageView;
+
+    /// <summary>
+    /// Texture descriptor sets replaced while a frame in flight may still use them, with the frames left until they can be removed
+    /// </summary>
+    std::vector<std::pair<VkDescriptorSet, uint32_t>> retiredTexDS;
 
 private: //                         PRIVATE FUNCTIONS
     
@@ -121,6 +217,17 @@ private: //                         PRIVATE FUNCTIONS
     /// <param name="commandBuffer">The command buffer to write to</param>
     /// <param name="imageIndex">Index of the swapchain image to write to</param>
     void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+    /// <summary>
+    /// Begins rendering to the swapchain image, with dynamic rendering where supported otherwise the render pass
+    /// </summary>
+    void beginRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+    /// <summary>
+    /// Ends rendering, leaving the swapchain image ready to present
+    /// </summary>
+    void endRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
     /// <summary>
     /// Renders a frame than adds it to the present queue to be presented to screen
     /// </summary>
@@ -128,6 +235,17 @@ private: //                         PRIVATE FUNCTIONS
 
     void updateUniformBuffer(uint32_t currentImage);
 
+    /// <summary>
+    /// Lays instanceCount copies of the model out in a grid centred on the origin
+    /// </summary>
+    void updateInstances();
+
+    /// <summary>
+    /// Rewrites the frame's texture binding if the texture was swapped in since it was last written,
+    /// only safe once the frame's fence has been waited on
+    /// </summary>
+    void updateTextureBindings(uint32_t frame);
+
     void drawImgui();
 
     /// <summary>
@@ -149,6 +267,11 @@ private: //                         PRIVATE FUNCTIONS
     void createDescriptorSetLayout();
     void createGraphicsPipeline();
 
+    /// <summary>
+    /// Requests the variant of the graphics pipeline for the chosen material and culling, drawn with once it has compiled
+    /// </summary>
+    void requestPipeline();
+
     void createTextureSampler();
 
     void createDescriptorPool();
@@ -164,15 +287,4 @@ private: //                         PRIVATE FUNCTIONS
     /// If window has resized, calls cleanupSwapchain() then creates new swapchain with new window size
     /// </summary>
     void recreateSwapchain();
-
-    /// <summary>
-    /// Creates a vulkan shader module from compiled binary code of the shader
-    /// </summary>
-    VkShaderModule createShaderModule(const std::vector<char>& code) const;
-
-    /// <summary>
-    /// Reads binary in from a file
-    /// </summary>
-    /// <param name="filename">path of file to read from</param>
-    static std::vector<char> readFile(const std::string& filename);
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "InstanceBuffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "Buffer.h"
+#include "Structures.h"
+
+InstanceBuffer::InstanceBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, uint32_t capacity) :
+    device(device), physicalDevice(physicalDevice) {
+    frameBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    for (FrameBuffer& frameBuffer : frameBuffers) {
+        createFrameBuffer(frameBuffer, capacity);
+    }
+}
+
+InstanceBuffer::~InstanceBuffer() = default;
+
+void InstanceBuffer::setInstances(std::vector<InstanceData> newInstances) {
+    instances = std::move(newInstances);
+    version++;
+}
+
+void InstanceBuffer::update(uint32_t frame) {
+    FrameBuffer& frameBuffer = frameBuffers[frame];
+    if (frameBuffer.version == version) return;
+
+    // the frame has finished with its buffer, so it can be replaced straight away
+    if (frameBuffer.capacity < instances.size()) {
+        createFrameBuffer(frameBuffer, static_cast<uint32_t>(instances.size()));
+    }
+
+    std::memcpy(frameBuffer.mapped, instances.data(), sizeof(InstanceData) * instances.size());
+    frameBuffer.version = version;
+}
+
+void InstanceBuffer::bind(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t binding) const {
+    const std::array<VkDeviceSize, 1> offsets = { 0 };
+    const std::array<VkBuffer, 1> buffers = { frameBuffers[frame].buffer->getBuffer() };
+    vkCmdBindVertexBuffers(commandBuffer, binding, static_cast<uint32_t>(buffers.size()), buffers.data(), offsets.data());
+}
+
+void InstanceBuffer::createFrameBuffer(FrameBuffer& frameBuffer, uint32_t capacity) {
+    // kept mapped like the uniform buffers, written by the CPU each time the instances change
+    capacity = std::max(capacity, 1u);
+    frameBuffer.buffer = std::make_unique<Buffer>(device, physicalDevice, sizeof(InstanceData) * capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    frameBuffer.buffer->mapMemory(&frameBuffer.mapped);
+    frameBuffer.capacity = capacity;
+    frameBuffer.version = 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "ModelData.h"
+#include <memory>
+#include <vector>
+
+class LogicalDevice;
+class PhysicalDevice;
+class Buffer;
+
+/// <summary>
+/// Per instance data read by the vertex shader from its own binding, so one draw renders every instance of a model.
+/// Each frame in flight has a host visible copy, only rewritten once the instances change and the frame has finished with it
+/// </summary>
+class InstanceBuffer {
+public:
+	/// <param name="capacity">Instances the buffers are first made to hold, they grow when more are set</param>
+	InstanceBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, uint32_t capacity);
+	~InstanceBuffer();
+
+	/// <summary>
+	/// Replaces the instances, each frame's copy is written the next time it's updated
+	/// </summary>
+	void setInstances(std::vector<InstanceData> newInstances);
+	const std::vector<InstanceData>& getInstances() const { return instances; }
+	const uint32_t getInstanceCount() const { return static_cast<uint32_t>(instances.size()); }
+
+	/// <summary>
+	/// Writes the instances into the frame's copy if they changed since it was last written, only safe once the frame's fence has been waited on
+	/// </summary>
+	void update(uint32_t frame);
+
+	/// <summary>
+	/// Binds the frame's copy as the vertex buffer of the instance binding
+	/// </summary>
+	void bind(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t binding) const;
+
+private:
+	struct FrameBuffer {
+		std::unique_ptr<Buffer> buffer;
+		void* mapped = nullptr;
+		uint32_t capacity = 0;
+
+		/// <summary>
+		/// Version of the instances last written, see InstanceBuffer::version
+		/// </summary>
+		uint64_t version = 0;
+	};
+
+	/// <summary>
+	/// Replaces the frame's buffer with one holding capacity instances
+	/// </summary>
+	void createFrameBuffer(FrameBuffer& frameBuffer, uint32_t capacity);
+
+private:
+	std::vector<InstanceData> instances;
+
+	/// <summary>
+	/// Counts changes to the instances, so each frame's copy knows whether it is out of date
+	/// </summary>
+	uint64_t version = 1;
+
+	std::vector<FrameBuffer> frameBuffers;
+
+	const std::unique_ptr<LogicalDevice>& device;
+	const std::unique_ptr<PhysicalDevice>& physicalDevice;
+};
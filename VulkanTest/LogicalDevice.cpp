@@ -24,6 +24,47 @@ LogicalDevice::LogicalDevice(const std::unique_ptr<PhysicalDevice>& physicalDevi
     // DEVICE FEATURES
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.multiDrawIndirect = physicalDevice->getMaxDrawIndirectCount() > 1 ? VK_TRUE : VK_FALSE;
+
+    // enable the extended dynamic state features the device has, see DynamicState
+    const DynamicStateSupport dynamicStateSupport = physicalDevice->getDynamicStateSupport();
+
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicState{};
+    extendedDynamicState.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    extendedDynamicState.extendedDynamicState = VK_TRUE;
+
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extendedDynamicState2{};
+    extendedDynamicState2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+    extendedDynamicState2.extendedDynamicState2 = VK_TRUE;
+
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3{};
+    extendedDynamicState3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+    extendedDynamicState3.extendedDynamicState3PolygonMode = dynamicStateSupport.polygonMode;
+    extendedDynamicState3.extendedDynamicState3ColorBlendEnable = dynamicStateSupport.colorBlendEnable;
+    extendedDynamicState3.extendedDynamicState3ColorBlendEquation = dynamicStateSupport.colorBlendEquation;
+
+    void* features = nullptr;
+    if (dynamicStateSupport.polygonMode || dynamicStateSupport.colorBlendEnable || dynamicStateSupport.colorBlendEquation) {
+        extendedDynamicState3.pNext = features;
+        features = &extendedDynamicState3;
+    }
+    if (dynamicStateSupport.extendedDynamicState2) {
+        extendedDynamicState2.pNext = features;
+        features = &extendedDynamicState2;
+    }
+    if (dynamicStateSupport.extendedDynamicState) {
+        extendedDynamicState.pNext = features;
+        features = &extendedDynamicState;
+    }
+
+    // and dynamic rendering, so no render pass or framebuffers are needed
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRendering{};
+    dynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    dynamicRendering.dynamicRendering = VK_TRUE;
+    if (physicalDevice->getDynamicRenderingSupport()) {
+        dynamicRendering.pNext = features;
+        features = &dynamicRendering;
+    }
 
     // LOGICAL DEVICE
     VkDeviceCreateInfo createInfo{};
@@ -31,8 +72,9 @@ LogicalDevice::LogicalDevice(const std::unique_ptr<PhysicalDevice>& physicalDevi
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.pEnabledFeatures = &deviceFeatures;
+    createInfo.pNext = features;
 
-    auto deviceExtensions = PhysicalDevice::getDeviceExtensions();
+    auto deviceExtensions = physicalDevice->getEnabledExtensions();
     createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
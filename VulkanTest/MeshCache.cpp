@@ -0,0 +1,292 @@
+#include "MeshCache.h"
+#include "MeshCodec.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace MeshCache {
+    namespace {
+        constexpr uint32_t CACHE_MAGIC = 0x48534D56; // "VMSH"
+
+        /// <summary>
+        /// Increase whenever the file layout or the processing that produces it changes
+        /// </summary>
+        constexpr uint32_t CACHE_VERSION = 5;
+
+        struct CacheHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t vertexStride;
+            uint32_t meshletStride;
+            uint64_t sourceSize;
+            uint64_t sourceHash;
+            uint32_t vertexCount;
+            uint32_t indexCount;
+            uint32_t lodCount;
+            uint32_t blockCount;
+            uint32_t meshletCount;
+            uint32_t meshletVertexCount;
+            uint32_t meshletTriangleBytes;
+            uint64_t encodedVertexBytes;
+            uint64_t encodedIndexBytes;
+            glm::vec3 boundsCenter;
+            float boundsRadius;
+        };
+
+        template<typename T>
+        void writeArray(std::ofstream& file, const std::vector<T>& values) {
+            file.write(reinterpret_cast<const char*>(values.data()), sizeof(T) * values.size());
+        }
+
+        template<typename T>
+        bool readValue(const char*& data, const char* end, T& value) {
+            if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+            std::memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+            return true;
+        }
+
+        template<typename T>
+        bool readArray(const char*& data, const char* end, std::vector<T>& values, size_t count) {
+            if (static_cast<size_t>(end - data) / sizeof(T) < count) return false;
+            values.resize(count);
+            if (count > 0) std::memcpy(values.data(), data, sizeof(T) * count);
+            data += sizeof(T) * count;
+            return true;
+        }
+
+        /// <summary>
+        /// Checks the counts read from a cache agree with each other, as the vertex and index counts size
+        /// the staging buffers before anything is decoded and every range is drawn or read from
+        /// </summary>
+        bool validateCache(const MeshCacheData& data) {
+            // each block's counts must match what its encoded data says it decodes to
+            uint64_t vertexCount = 0, indexCount = 0, vertexBytes = 0, indexBytes = 0;
+            for (const auto& block : data.encodedBlocks) {
+                if (block.vertexBytes > data.encodedVertices.size() - vertexBytes || block.indexBytes > data.encodedIndices.size() - indexBytes) return false;
+
+                size_t decodedVertexBytes = 0, decodedIndexBytes = 0;
+                if (!MeshCodec::getDecodedBytes(data.encodedVertices.data() + vertexBytes, block.vertexBytes, decodedVertexBytes)
+                    || !MeshCodec::getDecodedBytes(data.encodedIndices.data() + indexBytes, block.indexBytes, decodedIndexBytes)) {
+                    return false;
+                }
+                if (decodedVertexBytes != static_cast<uint64_t>(block.vertexCount) * sizeof(Vertex)
+                    || decodedIndexBytes < block.indexCount || decodedIndexBytes > static_cast<uint64_t>(block.indexCount) * 3) {
+                    return false;
+                }
+
+                vertexCount += block.vertexCount;
+                indexCount += block.indexCount;
+                vertexBytes += block.vertexBytes;
+                indexBytes += block.indexBytes;
+            }
+            if (vertexCount != data.vertexCount || indexCount != data.indexCount
+                || vertexBytes != data.encodedVertices.size() || indexBytes != data.encodedIndices.size()) {
+                return false;
+            }
+
+            if (data.lods.empty()) return false;
+            for (const auto& lod : data.lods) {
+                for (const auto& submesh : lod.submeshes) {
+                    if (static_cast<uint64_t>(submesh.firstIndex) + submesh.indexCount > data.indexCount
+                        || submesh.vertexOffset < 0 || static_cast<uint32_t>(submesh.vertexOffset) > data.vertexCount) {
+                        return false;
+                    }
+                }
+            }
+
+            for (const auto& meshlet : data.meshlets) {
+                if (static_cast<uint64_t>(meshlet.vertexOffset) + meshlet.vertexCount > data.meshletVertices.size()
+                    || (static_cast<uint64_t>(meshlet.triangleOffset) + meshlet.triangleCount) * 3 > data.meshletTriangles.size()
+                    || static_cast<uint64_t>(meshlet.firstIndex) + meshlet.triangleCount * 3ull > data.indexCount) {
+                    return false;
+                }
+            }
+            for (uint32_t vertex : data.meshletVertices) {
+                if (vertex >= data.vertexCount) return false;
+            }
+
+            return true;
+        }
+
+        /// <summary>
+        /// Reads a whole cache file already in memory
+        /// </summary>
+        bool parseCache(const std::vector<char>& file, MeshCacheData& data) {
+            const char* cursor = file.data();
+            const char* end = cursor + file.size();
+
+            CacheHeader header{};
+            if (!readValue(cursor, end, header)) return false;
+            if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION
+                || header.vertexStride != sizeof(Vertex) || header.meshletStride != sizeof(Meshlet)) {
+                return false;
+            }
+            data.sourceSize = header.sourceSize;
+            data.sourceHash = header.sourceHash;
+
+            data.vertexCount = header.vertexCount;
+            data.indexCount = header.indexCount;
+            data.boundsCenter = header.boundsCenter;
+            data.boundsRadius = header.boundsRadius;
+
+            // every level has at least its error and submesh count, so more levels than that can't fit in the file
+            constexpr size_t minLodBytes = sizeof(float) + sizeof(uint32_t);
+            if (static_cast<size_t>(end - cursor) / minLodBytes < header.lodCount) return false;
+
+            data.lods.resize(header.lodCount);
+            for (auto& lod : data.lods) {
+                uint32_t submeshCount = 0;
+                if (!readValue(cursor, end, lod.error)) return false;
+                if (!readValue(cursor, end, submeshCount)) return false;
+                if (!readArray(cursor, end, lod.submeshes, submeshCount)) return false;
+            }
+
+            if (!readArray(cursor, end, data.encodedBlocks, header.blockCount)) return false;
+
+            return readArray(cursor, end, data.meshlets, header.meshletCount)
+                && readArray(cursor, end, data.meshletVertices, header.meshletVertexCount)
+                && readArray(cursor, end, data.meshletTriangles, header.meshletTriangleBytes)
+                && readArray(cursor, end, data.encodedVertices, header.encodedVertexBytes)
+                && readArray(cursor, end, data.encodedIndices, header.encodedIndexBytes)
+                && cursor == end
+                && validateCache(data);
+        }
+    }
+
+    std::string getCachePath(const std::string& sourcePath) {
+        return sourcePath + ".meshcache";
+    }
+
+    bool read(const std::string& sourcePath, MeshCacheData& data) {
+        const std::string cachePath = getCachePath(sourcePath);
+
+        std::error_code error;
+        auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+        if (error) return false;
+        auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+        if (error || cacheTime < sourceTime) return false;
+        uintmax_t sourceSize = std::filesystem::file_size(sourcePath, error);
+        if (error) return false;
+
+        std::ifstream file(cachePath, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) return false;
+
+        std::vector<char> contents(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(contents.data(), contents.size())) return false;
+
+        return parseCache(contents, data) && data.sourceSize == sourceSize;
+    }
+
+    bool parse(const std::vector<char>& file, MeshCacheData& data) {
+        return parseCache(file, data);
+    }
+
+    void appendEncoded(const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices, MeshCacheData& data) {
+        const std::vector<uint8_t> encodedVertices = MeshCodec::encodeVertices(vertices.data(), vertices.size(), sizeof(Vertex));
+        const std::vector<uint8_t> encodedIndices = MeshCodec::encodeIndices(indices.data(), indices.size());
+
+        EncodedBlock block{};
+        block.vertexCount = static_cast<uint32_t>(vertices.size());
+        block.indexCount = static_cast<uint32_t>(indices.size());
+        block.vertexBytes = encodedVertices.size();
+        block.indexBytes = encodedIndices.size();
+        data.encodedBlocks.push_back(block);
+
+        data.vertexCount += block.vertexCount;
+        data.indexCount += block.indexCount;
+        data.encodedVertices.insert(data.encodedVertices.end(), encodedVertices.begin(), encodedVertices.end());
+        data.encodedIndices.insert(data.encodedIndices.end(), encodedIndices.begin(), encodedIndices.end());
+    }
+
+    bool decodeVertices(const MeshCacheData& data, Vertex* destination) {
+        const uint8_t* encoded = data.encodedVertices.data();
+        const uint8_t* end = encoded + data.encodedVertices.size();
+        Vertex* const destinationEnd = destination + data.vertexCount;
+
+        for (const auto& block : data.encodedBlocks) {
+            if (static_cast<uint64_t>(end - encoded) < block.vertexBytes || static_cast<size_t>(destinationEnd - destination) < block.vertexCount) return false;
+            if (!MeshCodec::decodeVertices(encoded, block.vertexBytes, destination, block.vertexCount, sizeof(Vertex))) return false;
+
+            encoded += block.vertexBytes;
+            destination += block.vertexCount;
+        }
+
+        return encoded == end && destination == destinationEnd;
+    }
+
+    bool decodeIndices(const MeshCacheData& data, uint16_t* destination) {
+        const uint8_t* encoded = data.encodedIndices.data();
+        const uint8_t* end = encoded + data.encodedIndices.size();
+        uint16_t* const destinationEnd = destination + data.indexCount;
+
+        for (const auto& block : data.encodedBlocks) {
+            if (static_cast<uint64_t>(end - encoded) < block.indexBytes || static_cast<size_t>(destinationEnd - destination) < block.indexCount) return false;
+            if (!MeshCodec::decodeIndices(encoded, block.indexBytes, destination, block.indexCount)) return false;
+
+            encoded += block.indexBytes;
+            destination += block.indexCount;
+        }
+
+        return encoded == end && destination == destinationEnd;
+    }
+
+    bool write(const std::string& sourcePath, const MeshCacheData& data) {
+        std::error_code error;
+
+        // written to a temporary file first so a failed write never leaves a truncated cache behind
+        const std::string cachePath = getCachePath(sourcePath);
+        const std::string tempPath = cachePath + ".tmp";
+        bool written = false;
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return false;
+
+            CacheHeader header{};
+            header.magic = CACHE_MAGIC;
+            header.version = CACHE_VERSION;
+            header.vertexStride = sizeof(Vertex);
+            header.meshletStride = sizeof(Meshlet);
+            header.sourceSize = data.sourceSize;
+            header.sourceHash = data.sourceHash;
+            header.vertexCount = data.vertexCount;
+            header.indexCount = data.indexCount;
+            header.lodCount = static_cast<uint32_t>(data.lods.size());
+            header.blockCount = static_cast<uint32_t>(data.encodedBlocks.size());
+            header.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+            header.meshletVertexCount = static_cast<uint32_t>(data.meshletVertices.size());
+            header.meshletTriangleBytes = static_cast<uint32_t>(data.meshletTriangles.size());
+            header.encodedVertexBytes = data.encodedVertices.size();
+            header.encodedIndexBytes = data.encodedIndices.size();
+            header.boundsCenter = data.boundsCenter;
+            header.boundsRadius = data.boundsRadius;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            for (const auto& lod : data.lods) {
+                uint32_t submeshCount = static_cast<uint32_t>(lod.submeshes.size());
+                file.write(reinterpret_cast<const char*>(&lod.error), sizeof(lod.error));
+                file.write(reinterpret_cast<const char*>(&submeshCount), sizeof(submeshCount));
+                writeArray(file, lod.submeshes);
+            }
+
+            writeArray(file, data.encodedBlocks);
+
+            writeArray(file, data.meshlets);
+            writeArray(file, data.meshletVertices);
+            writeArray(file, data.meshletTriangles);
+            writeArray(file, data.encodedVertices);
+            writeArray(file, data.encodedIndices);
+
+            written = static_cast<bool>(file);
+        }
+
+        if (!written) {
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        std::filesystem::rename(tempPath, cachePath, error);
+        return !error;
+    }
+}
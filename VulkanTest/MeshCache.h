@@ -0,0 +1,88 @@
+#pragma once
+#include "ModelData.h"
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Vertices and indices compressed together as one independent part of the encoded streams
+/// </summary>
+struct EncodedBlock {
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint64_t vertexBytes;
+	uint64_t indexBytes;
+};
+
+/// <summary>
+/// Processed mesh as stored in a cache file, with the vertex and index data left compressed
+/// so it can be decoded straight into staging memory, see MeshCodec
+/// </summary>
+struct MeshCacheData {
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+
+	/// <summary>
+	/// Size and ContentHash of the source the mesh was cooked from, zero for meshes cooked from memory
+	/// </summary>
+	uint64_t sourceSize = 0;
+	uint64_t sourceHash = 0;
+
+	glm::vec3 boundsCenter{};
+	float boundsRadius = 0.0f;
+
+	std::vector<MeshLod> lods;
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint8_t> meshletTriangles;
+
+	/// <summary>
+	/// Parts of the encoded streams in order, a single block unless the mesh was streamed a batch at a time
+	/// </summary>
+	std::vector<EncodedBlock> encodedBlocks;
+	std::vector<uint8_t> encodedVertices;
+	std::vector<uint8_t> encodedIndices;
+};
+
+/// <summary>
+/// Reads and writes processed meshes next to their source file so welding, simplification
+/// and meshlet building only happen when the source changes
+/// </summary>
+namespace MeshCache {
+	std::string getCachePath(const std::string& sourcePath);
+
+	/// <summary>
+	/// Reads the cache of a source file
+	/// </summary>
+	/// <returns>False if there is no cache, it is older than the source or it was written by a different version</returns>
+	bool read(const std::string& sourcePath, MeshCacheData& data);
+
+	/// <summary>
+	/// Reads a cache file already in memory, such as one from an AssetPack, without checking it against its source
+	/// </summary>
+	/// <returns>False if the cache is corrupt or was written by a different version</returns>
+	bool parse(const std::vector<char>& file, MeshCacheData& data);
+
+	/// <summary>
+	/// Compresses vertices and indices and appends them to the encoded streams as a new block
+	/// </summary>
+	void appendEncoded(const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices, MeshCacheData& data);
+
+	/// <summary>
+	/// Decodes every block's vertices straight into the destination, which holds data.vertexCount vertices
+	/// </summary>
+	/// <returns>False if the data is corrupt</returns>
+	bool decodeVertices(const MeshCacheData& data, Vertex* destination);
+
+	/// <summary>
+	/// Decodes every block's indices straight into the destination, which holds data.indexCount indices
+	/// </summary>
+	/// <returns>False if the data is corrupt</returns>
+	bool decodeIndices(const MeshCacheData& data, uint16_t* destination);
+
+	/// <summary>
+	/// Writes the cache of a source file, replacing any existing one. The cache is only read back while the source
+	/// is still data.sourceSize bytes, so that must be the size of the source it was cooked from
+	/// </summary>
+	/// <returns>False if the file couldn't be written</returns>
+	bool write(const std::string& sourcePath, const MeshCacheData& data);
+}
@@ -0,0 +1,401 @@
+#include "MeshCodec.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace MeshCodec {
+    namespace {
+        constexpr uint8_t MODE_RAW = 0;
+        constexpr uint8_t MODE_RANS = 1;
+
+        constexpr uint32_t PROB_BITS = 12;
+        constexpr uint32_t PROB_SCALE = 1u << PROB_BITS;
+
+        /// <summary>
+        /// Lower bound of the normalised rANS state, the state is kept in [RANS_LOWER, RANS_LOWER << 8)
+        /// </summary>
+        constexpr uint32_t RANS_LOWER = 1u << 23;
+
+        template<typename T>
+        void appendValue(std::vector<uint8_t>& out, T value) {
+            size_t offset = out.size();
+            out.resize(offset + sizeof(T));
+            std::memcpy(out.data() + offset, &value, sizeof(T));
+        }
+
+        template<typename T>
+        bool readValue(const uint8_t*& data, const uint8_t* end, T& value) {
+            if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+            std::memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+            return true;
+        }
+
+        /// <summary>
+        /// Scales byte counts so they sum to PROB_SCALE, keeping every byte that occurs at a frequency of at least one
+        /// </summary>
+        std::array<uint16_t, 256> normaliseFrequencies(const std::array<uint32_t, 256>& counts, size_t total) {
+            std::array<uint16_t, 256> frequencies{};
+            uint32_t sum = 0;
+            for (size_t i = 0; i < 256; i++) {
+                if (counts[i] == 0) continue;
+                uint32_t scaled = static_cast<uint32_t>((static_cast<uint64_t>(counts[i]) * PROB_SCALE) / total);
+                frequencies[i] = static_cast<uint16_t>(std::max(scaled, 1u));
+                sum += frequencies[i];
+            }
+
+            // rounding leaves the sum slightly off, take from or give to the most frequent bytes where it costs least
+            while (sum != PROB_SCALE) {
+                size_t largest = 0;
+                for (size_t i = 1; i < 256; i++) {
+                    if (frequencies[i] > frequencies[largest]) largest = i;
+                }
+
+                if (sum > PROB_SCALE) {
+                    frequencies[largest]--;
+                    sum--;
+                } else {
+                    frequencies[largest]++;
+                    sum++;
+                }
+            }
+            return frequencies;
+        }
+
+        /// <summary>
+        /// Order 0 rANS coding with byte wise renormalisation, stored raw instead if that would be smaller
+        /// </summary>
+        std::vector<uint8_t> entropyEncode(const std::vector<uint8_t>& input) {
+            std::vector<uint8_t> out;
+            appendValue(out, MODE_RAW);
+            appendValue(out, static_cast<uint32_t>(input.size()));
+
+            if (!input.empty()) {
+                std::array<uint32_t, 256> counts{};
+                for (uint8_t byte : input) counts[byte]++;
+
+                std::array<uint16_t, 256> frequencies = normaliseFrequencies(counts, input.size());
+                std::array<uint32_t, 256> cumulative{};
+                for (size_t i = 1; i < 256; i++) {
+                    cumulative[i] = cumulative[i - 1] + frequencies[i - 1];
+                }
+
+                // rANS decodes in the opposite order it encodes, so encode backwards from the end of the buffer
+                std::vector<uint8_t> encoded(input.size() + input.size() / 2 + 16);
+                uint8_t* begin = encoded.data();
+                uint8_t* ptr = begin + encoded.size();
+                uint32_t state = RANS_LOWER;
+                bool fits = true;
+
+                for (size_t i = input.size(); i-- > 0;) {
+                    uint32_t frequency = frequencies[input[i]];
+                    uint32_t stateMax = ((RANS_LOWER >> PROB_BITS) << 8) * frequency;
+                    while (state >= stateMax) {
+                        *--ptr = static_cast<uint8_t>(state & 0xff);
+                        state >>= 8;
+                    }
+                    state = ((state / frequency) << PROB_BITS) + (state % frequency) + cumulative[input[i]];
+
+                    if (ptr - begin < 8) {
+                        fits = false;
+                        break;
+                    }
+                }
+
+                size_t encodedSize = static_cast<size_t>(begin + encoded.size() - ptr) + sizeof(state);
+                if (fits && sizeof(frequencies) + encodedSize < input.size()) {
+                    ptr -= sizeof(state);
+                    std::memcpy(ptr, &state, sizeof(state));
+
+                    out[0] = MODE_RANS;
+                    out.insert(out.end(), reinterpret_cast<const uint8_t*>(frequencies.data()),
+                               reinterpret_cast<const uint8_t*>(frequencies.data()) + sizeof(frequencies));
+                    out.insert(out.end(), ptr, begin + encoded.size());
+                    return out;
+                }
+            }
+
+            out.insert(out.end(), input.begin(), input.end());
+            return out;
+        }
+
+        /// <summary>
+        /// Decodes an entropyEncode stream a few bytes at a time, so callers never need a buffer for all of it
+        /// </summary>
+        class EntropyDecoder {
+        public:
+            /// <returns>False if the header is corrupt</returns>
+            bool begin(const uint8_t* data, size_t size) {
+                end = data + size;
+                if (!readValue(data, end, mode) || !readValue(data, end, remaining)) return false;
+
+                if (mode == MODE_RAW) {
+                    this->data = data;
+                    return static_cast<size_t>(end - data) == remaining;
+                }
+                if (mode != MODE_RANS) return false;
+
+                std::array<uint16_t, 256> readFrequencies;
+                if (!readValue(data, end, readFrequencies)) return false;
+
+                uint32_t slot = 0;
+                for (size_t i = 0; i < 256; i++) {
+                    frequencies[i] = readFrequencies[i];
+                    cumulative[i] = slot;
+                    if (slot + frequencies[i] > PROB_SCALE) return false;
+                    std::memset(slotSymbols.data() + slot, static_cast<int>(i), frequencies[i]);
+                    slot += frequencies[i];
+                }
+                if (slot != PROB_SCALE) return false;
+
+                if (!readValue(data, end, state)) return false;
+                this->data = data;
+                return true;
+            }
+
+            /// <returns>False if the stream is corrupt or has fewer than count bytes left</returns>
+            bool decode(uint8_t* output, size_t count) {
+                if (count > remaining) return false;
+                remaining -= static_cast<uint32_t>(count);
+
+                if (mode == MODE_RAW) {
+                    std::memcpy(output, data, count);
+                    data += count;
+                    return true;
+                }
+
+                for (size_t i = 0; i < count; i++) {
+                    uint32_t stateSlot = state & (PROB_SCALE - 1);
+                    uint8_t symbol = slotSymbols[stateSlot];
+                    output[i] = symbol;
+
+                    state = frequencies[symbol] * (state >> PROB_BITS) + stateSlot - cumulative[symbol];
+                    while (state < RANS_LOWER) {
+                        if (data == end) return false;
+                        state = (state << 8) | *data++;
+                    }
+                }
+                return true;
+            }
+
+            /// <summary>
+            /// Whether every byte was decoded and all of the encoded data used, anything left over means it is corrupt
+            /// </summary>
+            bool finished() const { return remaining == 0 && data == end; }
+
+        private:
+            const uint8_t* data = nullptr;
+            const uint8_t* end = nullptr;
+            uint8_t mode = MODE_RAW;
+            uint32_t remaining = 0;
+            uint32_t state = 0;
+            std::array<uint32_t, 256> frequencies{};
+            std::array<uint32_t, 256> cumulative{};
+            std::array<uint8_t, PROB_SCALE> slotSymbols;
+        };
+
+        /// <summary>
+        /// Vertices whose byte planes are stored together, so decoding only ever holds one block of planes
+        /// </summary>
+        constexpr size_t VERTEX_BLOCK_SIZE = 256;
+
+#ifdef MESH_CODEC_SSE2
+        /// <summary>
+        /// Running sum of the 16 bytes in a register, plus the carry from the previous register
+        /// </summary>
+        inline __m128i prefixSumBytes(__m128i value, __m128i carry) {
+            value = _mm_add_epi8(value, _mm_slli_si128(value, 1));
+            value = _mm_add_epi8(value, _mm_slli_si128(value, 2));
+            value = _mm_add_epi8(value, _mm_slli_si128(value, 4));
+            value = _mm_add_epi8(value, _mm_slli_si128(value, 8));
+            return _mm_add_epi8(value, carry);
+        }
+
+        /// <summary>
+        /// Broadcasts the last byte of a register to all 16 bytes
+        /// </summary>
+        inline __m128i broadcastLastByte(__m128i value) {
+            value = _mm_unpackhi_epi8(value, value);
+            value = _mm_unpackhi_epi16(value, value);
+            return _mm_shuffle_epi32(value, 0xFF);
+        }
+
+        /// <summary>
+        /// Transposes 16 planes of 16 vertices each into 16 bytes of each of the 16 vertices
+        /// </summary>
+        void transpose16x16(const __m128i planes[16], __m128i vertices[16]) {
+            // each step doubles the width of the interleaved elements, pairing up planes then vertices
+            __m128i pairs[8][2];
+            for (int i = 0; i < 8; i++) {
+                pairs[i][0] = _mm_unpacklo_epi8(planes[2 * i], planes[2 * i + 1]);
+                pairs[i][1] = _mm_unpackhi_epi8(planes[2 * i], planes[2 * i + 1]);
+            }
+
+            __m128i quads[4][4];
+            for (int i = 0; i < 4; i++) {
+                for (int half = 0; half < 2; half++) {
+                    quads[i][half * 2] = _mm_unpacklo_epi16(pairs[2 * i][half], pairs[2 * i + 1][half]);
+                    quads[i][half * 2 + 1] = _mm_unpackhi_epi16(pairs[2 * i][half], pairs[2 * i + 1][half]);
+                }
+            }
+
+            __m128i octs[2][8];
+            for (int i = 0; i < 2; i++) {
+                for (int group = 0; group < 4; group++) {
+                    octs[i][group * 2] = _mm_unpacklo_epi32(quads[2 * i][group], quads[2 * i + 1][group]);
+                    octs[i][group * 2 + 1] = _mm_unpackhi_epi32(quads[2 * i][group], quads[2 * i + 1][group]);
+                }
+            }
+
+            for (int group = 0; group < 8; group++) {
+                vertices[group * 2] = _mm_unpacklo_epi64(octs[0][group], octs[1][group]);
+                vertices[group * 2 + 1] = _mm_unpackhi_epi64(octs[0][group], octs[1][group]);
+            }
+        }
+#endif
+    }
+
+    bool getDecodedBytes(const uint8_t* data, size_t size, size_t& bytes) {
+        const uint8_t* end = data + size;
+        uint8_t mode;
+        uint32_t rawSize;
+        if (!readValue(data, end, mode) || !readValue(data, end, rawSize)) return false;
+        if (mode == MODE_RAW && static_cast<size_t>(end - data) != rawSize) return false;
+        if (mode != MODE_RAW && mode != MODE_RANS) return false;
+
+        bytes = rawSize;
+        return true;
+    }
+
+    std::vector<uint8_t> encodeVertices(const void* vertices, size_t vertexCount, size_t vertexStride) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+
+        // byte k of every vertex in a block is stored together as the difference from byte k of the previous vertex,
+        // similar vertices then give planes of mostly small values which entropy code well
+        std::vector<uint8_t> planes(vertexCount * vertexStride);
+        for (size_t blockStart = 0; blockStart < vertexCount; blockStart += VERTEX_BLOCK_SIZE) {
+            const size_t blockVertices = std::min(VERTEX_BLOCK_SIZE, vertexCount - blockStart);
+            for (size_t k = 0; k < vertexStride; k++) {
+                uint8_t* plane = planes.data() + blockStart * vertexStride + k * blockVertices;
+                uint8_t previous = blockStart > 0 ? bytes[(blockStart - 1) * vertexStride + k] : 0;
+                for (size_t i = 0; i < blockVertices; i++) {
+                    uint8_t value = bytes[(blockStart + i) * vertexStride + k];
+                    plane[i] = static_cast<uint8_t>(value - previous);
+                    previous = value;
+                }
+            }
+        }
+
+        return entropyEncode(planes);
+    }
+
+    bool decodeVertices(const uint8_t* data, size_t size, void* destination, size_t vertexCount, size_t vertexStride) {
+        EntropyDecoder decoder;
+        if (!decoder.begin(data, size)) return false;
+
+        // one block of planes at a time, the last vertex's bytes carry the deltas on into the next block
+        std::vector<uint8_t> planes(std::min(VERTEX_BLOCK_SIZE, vertexCount) * vertexStride);
+        std::vector<uint8_t> previous(vertexStride, 0);
+        uint8_t* out = static_cast<uint8_t*>(destination);
+
+        for (size_t blockStart = 0; blockStart < vertexCount; blockStart += VERTEX_BLOCK_SIZE) {
+            const size_t blockVertices = std::min(VERTEX_BLOCK_SIZE, vertexCount - blockStart);
+            if (!decoder.decode(planes.data(), blockVertices * vertexStride)) return false;
+
+            uint8_t* blockOut = out + blockStart * vertexStride;
+            size_t decoded = 0;
+
+#ifdef MESH_CODEC_SSE2
+            if (vertexStride % 16 == 0) {
+                const size_t runCount = blockVertices / 16;
+                for (size_t group = 0; group < vertexStride / 16; group++) {
+                    __m128i carries[16];
+                    for (int p = 0; p < 16; p++) carries[p] = _mm_set1_epi8(static_cast<char>(previous[group * 16 + p]));
+
+                    for (size_t run = 0; run < runCount; run++) {
+                        __m128i values[16];
+                        for (int p = 0; p < 16; p++) {
+                            const uint8_t* plane = planes.data() + (group * 16 + p) * blockVertices + run * 16;
+                            values[p] = prefixSumBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(plane)), carries[p]);
+                            carries[p] = broadcastLastByte(values[p]);
+                        }
+
+                        __m128i rows[16];
+                        transpose16x16(values, rows);
+                        for (int v = 0; v < 16; v++) {
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(blockOut + (run * 16 + v) * vertexStride + group * 16), rows[v]);
+                        }
+                    }
+
+                    for (int p = 0; p < 16; p++) previous[group * 16 + p] = static_cast<uint8_t>(_mm_cvtsi128_si32(carries[p]));
+                }
+                decoded = runCount * 16;
+            }
+#endif
+
+            for (size_t k = 0; k < vertexStride; k++) {
+                const uint8_t* plane = planes.data() + k * blockVertices;
+                uint8_t value = previous[k];
+                for (size_t i = decoded; i < blockVertices; i++) {
+                    value = static_cast<uint8_t>(value + plane[i]);
+                    blockOut[i * vertexStride + k] = value;
+                }
+                previous[k] = value;
+            }
+        }
+        return decoder.finished();
+    }
+
+    std::vector<uint8_t> encodeIndices(const uint16_t* indices, size_t indexCount) {
+        // triangles that share vertices are next to each other after meshlet building,
+        // so most indices are close to the previous one and zigzag into a single varint byte
+        std::vector<uint8_t> varints;
+        varints.reserve(indexCount + indexCount / 4);
+
+        int32_t previous = 0;
+        for (size_t i = 0; i < indexCount; i++) {
+            int32_t delta = static_cast<int32_t>(indices[i]) - previous;
+            previous = indices[i];
+
+            uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+            while (zigzag >= 0x80) {
+                varints.push_back(static_cast<uint8_t>(zigzag | 0x80));
+                zigzag >>= 7;
+            }
+            varints.push_back(static_cast<uint8_t>(zigzag));
+        }
+
+        return entropyEncode(varints);
+    }
+
+    bool decodeIndices(const uint8_t* data, size_t size, uint16_t* destination, size_t indexCount) {
+        // varints are pulled from the decoder a byte at a time, they are read once so there's nothing to gain from a buffer
+        EntropyDecoder decoder;
+        if (!decoder.begin(data, size)) return false;
+
+        int32_t previous = 0;
+        for (size_t i = 0; i < indexCount; i++) {
+            uint32_t zigzag = 0;
+            for (uint32_t shift = 0;; shift += 7) {
+                uint8_t byte;
+                if (shift > 28 || !decoder.decode(&byte, 1)) return false;
+                zigzag |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) break;
+            }
+
+            int32_t delta = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+            if (delta < -UINT16_MAX || delta > UINT16_MAX) return false;
+
+            // the encoder only ever steps between 16 bit values, anything else is corrupt
+            previous += delta;
+            if (previous < 0 || previous > UINT16_MAX) return false;
+            destination[i] = static_cast<uint16_t>(previous);
+        }
+        return decoder.finished();
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// Compression of vertex and index data for mesh files on disk. Indices are delta and zigzag coded into
+/// varints, vertices are split into delta coded byte planes per block of 256, then both go through an order 0 rANS entropy coder
+/// </summary>
+namespace MeshCodec {
+	/// <summary>
+	/// Reads how many bytes encoded vertices or indices decode to from their header, without decoding them.
+	/// Vertices decode to vertexCount * vertexStride bytes, indices to between one and three bytes each
+	/// </summary>
+	/// <returns>False if the header is corrupt</returns>
+	bool getDecodedBytes(const uint8_t* data, size_t size, size_t& bytes);
+
+	std::vector<uint8_t> encodeVertices(const void* vertices, size_t vertexCount, size_t vertexStride);
+
+	/// <summary>
+	/// Decodes vertices straight into the destination, which can be mapped staging memory as it is only written to, in order.
+	/// Only one block of planes is decoded at a time, so the memory used doesn't grow with the vertex count
+	/// </summary>
+	/// <returns>False if the data is corrupt or doesn't hold vertexCount vertices of vertexStride bytes</returns>
+	bool decodeVertices(const uint8_t* data, size_t size, void* destination, size_t vertexCount, size_t vertexStride);
+
+	std::vector<uint8_t> encodeIndices(const uint16_t* indices, size_t indexCount);
+
+	/// <summary>
+	/// Decodes indices straight into the destination, without buffering the varints
+	/// </summary>
+	/// <returns>False if the data is corrupt or doesn't hold indexCount indices</returns>
+	bool decodeIndices(const uint8_t* data, size_t size, uint16_t* destination, size_t indexCount);
+}
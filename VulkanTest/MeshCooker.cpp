@@ -0,0 +1,216 @@
+#include "MeshCooker.h"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <filesystem>
+#include <fstream>
+#include <streambuf>
+#include <unordered_map>
+
+#include "ContentHash.h"
+#include "MeshProcessing.h"
+#include "ObjStreamReader.h"
+#include "Debug.h"
+
+namespace MeshCooker {
+    namespace {
+        /// <summary>
+        /// Calculates the bounding sphere used to pick the level of detail
+        /// </summary>
+        void computeBounds(const std::vector<Vertex>& vertices, MeshCacheData& cache) {
+            glm::vec3 minPos = vertices.empty() ? glm::vec3(0.0f) : vertices[0].pos;
+            glm::vec3 maxPos = minPos;
+            for (const auto& vertex : vertices) {
+                minPos = glm::min(minPos, vertex.pos);
+                maxPos = glm::max(maxPos, vertex.pos);
+            }
+
+            cache.boundsCenter = (minPos + maxPos) * 0.5f;
+            cache.boundsRadius = 0.0f;
+            for (const auto& vertex : vertices) {
+                cache.boundsRadius = std::max(cache.boundsRadius, glm::distance(cache.boundsCenter, vertex.pos));
+            }
+        }
+
+        /// <summary>
+        /// Streams the obj in bounded batches, see ObjStreamReader. Each batch is turned into meshlets and compressed
+        /// before the next is read, so only one batch is ever held uncompressed. What grows with the mesh is the
+        /// compressed streams, the meshlet tables and the reader's positions and texture coordinates
+        /// </summary>
+        MeshCacheData streamObj(const std::string& path) {
+            ObjStreamReader reader(path);
+            MeshBatch batch;
+
+            MeshCacheData cache;
+
+            // each batch already fits 16 bit indices so becomes its own submesh, simplifying needs the
+            // whole mesh at once so streamed models only get the one level of detail
+            cache.lods.resize(1);
+            cache.lods[0].error = 0.0f;
+
+            glm::vec3 minPos(std::numeric_limits<float>::max());
+            glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+
+            while (reader.nextBatch(batch)) {
+                Submesh submesh{};
+                submesh.indexCount = static_cast<uint32_t>(batch.indices.size());
+
+                // meshlets are built against the batch alone then moved to where the batch goes in the whole mesh
+                const size_t firstMeshlet = cache.meshlets.size();
+                const size_t firstMeshletVertex = cache.meshletVertices.size();
+                MeshProcessing::buildMeshlets(batch.vertices, batch.indices, { submesh }, cache.meshlets, cache.meshletVertices, cache.meshletTriangles);
+                for (size_t i = firstMeshlet; i < cache.meshlets.size(); i++) {
+                    cache.meshlets[i].firstIndex += cache.indexCount;
+                    cache.meshlets[i].baseVertex += static_cast<int32_t>(cache.vertexCount);
+                }
+                for (size_t i = firstMeshletVertex; i < cache.meshletVertices.size(); i++) {
+                    cache.meshletVertices[i] += cache.vertexCount;
+                }
+
+                submesh.firstIndex = cache.indexCount;
+                submesh.vertexOffset = static_cast<int32_t>(cache.vertexCount);
+                cache.lods[0].submeshes.push_back(submesh);
+
+                for (const auto& vertex : batch.vertices) {
+                    minPos = glm::min(minPos, vertex.pos);
+                    maxPos = glm::max(maxPos, vertex.pos);
+                }
+
+                MeshCache::appendEncoded(batch.vertices, batch.indices, cache);
+            }
+
+            // the vertices are gone by now, so the sphere is the one around the bounding box rather than the tightest
+            if (cache.vertexCount > 0) {
+                cache.boundsCenter = (minPos + maxPos) * 0.5f;
+                cache.boundsRadius = glm::distance(minPos, maxPos) * 0.5f;
+            }
+
+            cache.sourceSize = reader.getBytesRead();
+            cache.sourceHash = reader.getContentHash();
+            return cache;
+        }
+
+        /// <summary>
+        /// Lets tinyobj parse a file already in memory without copying it into a string stream
+        /// </summary>
+        struct MemoryBuffer : std::streambuf {
+            MemoryBuffer(std::vector<char>& data) {
+                setg(data.data(), data.data(), data.data() + data.size());
+            }
+        };
+
+        /// <summary>
+        /// Loads the whole obj with tinyobj then welds and processes it
+        /// </summary>
+        MeshCacheData loadObj(const std::string& path) {
+            // read once and hashed in memory, as the source's hash identifies the model when it is loaded
+            std::ifstream file(path, std::ios::ate | std::ios::binary);
+            if (!file.is_open()) {
+                Debug::exception("failed to open obj file");
+            }
+            std::vector<char> contents(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            if (!file.read(contents.data(), contents.size())) {
+                Debug::exception("failed to read obj file");
+            }
+
+            MemoryBuffer buffer(contents);
+            std::istream stream(&buffer);
+
+            tinyobj::attrib_t attrib;
+            std::vector<tinyobj::shape_t> shapes;
+            std::vector<tinyobj::material_t> materials;
+            std::string warn, err;
+            tinyobj::MaterialFileReader materialReader("");
+
+            if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream, &materialReader)) {
+                Debug::exception(warn + err);
+            }
+
+            std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+            std::vector<Vertex> weldedVertices;
+            std::vector<uint32_t> weldedIndices;
+
+            for (const auto& shape : shapes) {
+                for (const auto& index : shape.mesh.indices) {
+                    Vertex vertex{};
+
+                    vertex.pos = {
+                        attrib.vertices[3 * index.vertex_index + 0],
+                        attrib.vertices[3 * index.vertex_index + 1],
+                        attrib.vertices[3 * index.vertex_index + 2]
+                    };
+
+                    vertex.texCoord = {
+                        attrib.texcoords[2 * index.texcoord_index + 0],
+                        1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+                    };
+
+                    vertex.color = { 1.0f, 1.0f, 1.0f };
+
+                    if (uniqueVertices.count(vertex) == 0) {
+                        uniqueVertices[vertex] = static_cast<uint32_t>(weldedVertices.size());
+                        weldedVertices.push_back(vertex);
+                    }
+
+                    weldedIndices.push_back(uniqueVertices[vertex]);
+                }
+            }
+
+            MeshCacheData cache = cookMesh(weldedVertices, std::move(weldedIndices));
+            cache.sourceSize = contents.size();
+            cache.sourceHash = ContentHash::hash(contents.data(), contents.size());
+            return cache;
+        }
+    }
+
+    MeshCacheData cookObj(const std::string& path) {
+        // very large files are streamed so the whole obj is never in memory at once
+        std::error_code sizeError;
+        const uintmax_t fileSize = std::filesystem::file_size(path, sizeError);
+        if (!sizeError && fileSize > STREAMING_THRESHOLD) {
+            return streamObj(path);
+        }
+        return loadObj(path);
+    }
+
+    MeshCacheData cookMesh(const std::vector<Vertex>& weldedVertices, std::vector<uint32_t> weldedIndices) {
+        MeshCacheData cache;
+        computeBounds(weldedVertices, cache);
+
+        // simplify each level of detail from the one before, so the errors add up
+        std::vector<std::vector<uint32_t>> lodIndices = { std::move(weldedIndices) };
+        std::vector<float> lodErrors = { 0.0f };
+        while (lodIndices.size() < MAX_LOD_COUNT) {
+            const auto& previous = lodIndices.back();
+            size_t targetIndexCount = static_cast<size_t>(previous.size() / 3 * LOD_REDUCTION) * 3;
+
+            // error is unbounded as a level is only picked once its error is too small to see
+            float error = 0.0f;
+            auto simplified = MeshProcessing::simplify(weldedVertices, previous, targetIndexCount, std::numeric_limits<float>::max(), error);
+
+            // locked seams and borders can stop simplification, not worth another level if so
+            if (simplified.empty() || simplified.size() > previous.size() * 0.9f) break;
+
+            lodErrors.push_back(lodErrors.back() + error);
+            lodIndices.push_back(std::move(simplified));
+        }
+
+        cache.lods.resize(lodIndices.size());
+        for (size_t i = 0; i < cache.lods.size(); i++) {
+            cache.lods[i].error = lodErrors[i];
+        }
+
+        // 16 bit indices halve index memory, meshes too large for them are split into submeshes
+        std::vector<Vertex> vertices;
+        std::vector<uint16_t> indices;
+        MeshProcessing::buildShortIndexLods(weldedVertices, lodIndices, vertices, indices, cache.lods);
+
+        // clusters for culling below the whole object, also reorders the indices so each is a contiguous range
+        MeshProcessing::buildMeshlets(vertices, indices, cache.lods[0].submeshes, cache.meshlets, cache.meshletVertices, cache.meshletTriangles);
+
+        MeshCache::appendEncoded(vertices, indices, cache);
+        return cache;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "MeshCache.h"
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Turns source meshes into processed mesh caches: welding, levels of detail, 16 bit submeshes, meshlets and
+/// compression. Shared by the AssetCooker and Model, so a cooked mesh only has to be decoded at runtime
+/// </summary>
+namespace MeshCooker {
+	/// <summary>
+	/// Obj files larger than this many bytes are streamed in batches rather than loaded whole
+	/// </summary>
+	constexpr uintmax_t STREAMING_THRESHOLD = 256ull << 20;
+
+	/// <summary>
+	/// Loads and processes an obj file, streaming it if it is larger than STREAMING_THRESHOLD. The file is read once,
+	/// its size and ContentHash recorded in the cache as it is
+	/// </summary>
+	MeshCacheData cookObj(const std::string& path);
+
+	/// <summary>
+	/// Processes an already welded mesh
+	/// </summary>
+	MeshCacheData cookMesh(const std::vector<Vertex>& weldedVertices, std::vector<uint32_t> weldedIndices);
+}
@@ -0,0 +1,590 @@
+#include "MeshProcessing.h"
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+
+namespace MeshProcessing {
+    namespace {
+        /// <summary>
+        /// Symmetric 4x4 matrix summing weighted squared distances to a set of planes, along with the total weight
+        /// so the sum can be turned back into a distance
+        /// </summary>
+        struct Quadric {
+            double a2 = 0, ab = 0, ac = 0, ad = 0;
+            double b2 = 0, bc = 0, bd = 0;
+            double c2 = 0, cd = 0;
+            double d2 = 0;
+            double weight = 0;
+
+            static constexpr Quadric fromPlane(double a, double b, double c, double d, double weight) {
+                Quadric q;
+                q.a2 = a * a * weight; q.ab = a * b * weight; q.ac = a * c * weight; q.ad = a * d * weight;
+                q.b2 = b * b * weight; q.bc = b * c * weight; q.bd = b * d * weight;
+                q.c2 = c * c * weight; q.cd = c * d * weight;
+                q.d2 = d * d * weight;
+                q.weight = weight;
+                return q;
+            }
+
+            constexpr void add(const Quadric& other) {
+                a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+                b2 += other.b2; bc += other.bc; bd += other.bd;
+                c2 += other.c2; cd += other.cd;
+                d2 += other.d2;
+                weight += other.weight;
+            }
+
+            constexpr double evaluate(double x, double y, double z) const {
+                return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                    + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                    + c2 * z * z + 2 * cd * z
+                    + d2;
+            }
+
+            /// <summary>
+            /// Weighted mean squared distance from p to the planes, in model units squared whatever the planes were weighted by
+            /// </summary>
+            constexpr double error(double x, double y, double z) const {
+                return weight > 0 ? std::max(evaluate(x, y, z) / weight, 0.0) : 0.0;
+            }
+
+            double error(const glm::vec3& p) const {
+                return error(p.x, p.y, p.z);
+            }
+        };
+
+        // the error of a point a known distance off the planes is that distance squared, however large the triangles
+        constexpr double testPlaneError(double offset, double firstWeight, double secondWeight) {
+            Quadric q = Quadric::fromPlane(0, 0, 1, 0, firstWeight);
+            q.add(Quadric::fromPlane(0, 0, 1, 0, secondWeight));
+            return q.error(0, 0, offset);
+        }
+        static_assert(testPlaneError(0.25, 3.0, 5.0) == 0.25 * 0.25);
+        static_assert(testPlaneError(0.25, 3000.0, 5000.0) == 0.25 * 0.25);
+        static_assert(testPlaneError(2.0, 0.125, 0.5) == 2.0 * 2.0);
+
+        struct Collapse {
+            float cost;
+            uint32_t from;
+            uint32_t to;
+            uint32_t fromVersion;
+            uint32_t toVersion;
+
+            bool operator>(const Collapse& other) const { return cost > other.cost; }
+        };
+
+        /// <summary>
+        /// Fills in the bounding sphere and normal cone of a meshlet from its vertices and triangles
+        /// </summary>
+        void computeMeshletBounds(Meshlet& meshlet, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& meshletVertices, const std::vector<uint8_t>& meshletTriangles) {
+            auto position = [&](uint32_t triangle, uint32_t corner) -> const glm::vec3& {
+                uint8_t local = meshletTriangles[(meshlet.triangleOffset + triangle) * 3 + corner];
+                return vertices[meshletVertices[meshlet.vertexOffset + local]].pos;
+            };
+
+            // sphere around the centre of the bounding box
+            glm::vec3 minPos = vertices[meshletVertices[meshlet.vertexOffset]].pos;
+            glm::vec3 maxPos = minPos;
+            for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+                minPos = glm::min(minPos, vertices[meshletVertices[meshlet.vertexOffset + i]].pos);
+                maxPos = glm::max(maxPos, vertices[meshletVertices[meshlet.vertexOffset + i]].pos);
+            }
+
+            meshlet.center = (minPos + maxPos) * 0.5f;
+            meshlet.radius = 0.0f;
+            for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+                meshlet.radius = std::max(meshlet.radius, glm::distance(meshlet.center, vertices[meshletVertices[meshlet.vertexOffset + i]].pos));
+            }
+
+            // cone axis is the average triangle normal, area weighted as the cross product isn't normalised first
+            std::vector<glm::vec3> normals(meshlet.triangleCount);
+            glm::vec3 axis(0.0f);
+            for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+                glm::vec3 normal = glm::cross(position(t, 1) - position(t, 0), position(t, 2) - position(t, 0));
+                float area = glm::length(normal);
+                normals[t] = area > 0.0f ? normal / area : glm::vec3(0.0f);
+                axis += normal;
+            }
+
+            float axisLength = glm::length(axis);
+            axis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f);
+
+            float minDot = 1.0f;
+            for (const auto& normal : normals) {
+                if (normal == glm::vec3(0.0f)) continue; // degenerate triangles can't face away
+                minDot = std::min(minDot, glm::dot(axis, normal));
+            }
+
+            // triangles spread over more than ~84 degrees so the cone can never be fully back facing
+            if (axisLength == 0.0f || minDot <= 0.1f) {
+                meshlet.coneAxis = glm::vec3(0.0f);
+                meshlet.coneCutoff = 1.0f;
+                meshlet.coneApex = meshlet.center;
+                return;
+            }
+
+            // move the apex back along the axis until it's behind every triangle's plane
+            float maxT = 0.0f;
+            for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+                float normalDot = glm::dot(axis, normals[t]);
+                if (normalDot <= 0.0f) continue;
+
+                float t0 = glm::dot(meshlet.center - position(t, 0), normals[t]) / normalDot;
+                maxT = std::max(maxT, t0);
+            }
+
+            meshlet.coneAxis = axis;
+            meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+            meshlet.coneApex = meshlet.center - axis * maxT;
+        }
+    }
+
+    std::vector<uint32_t> simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float& resultError) {
+        resultError = 0.0f;
+
+        const size_t vertexCount = vertices.size();
+        const size_t triangleCount = indices.size() / 3;
+        std::vector<uint32_t> triangles(indices.begin(), indices.begin() + triangleCount * 3);
+
+        // vertices at the same position, such as either side of a uv seam, are wedges of it. A position is numbered by
+        // its first vertex, and each vertex links to the next wedge of its position in a ring
+        std::vector<uint32_t> positionIds(vertexCount);
+        std::vector<uint32_t> nextWedge(vertexCount);
+        std::vector<uint32_t> wedgeCounts(vertexCount, 0);
+        std::unordered_map<glm::vec3, uint32_t> firstVertices;
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            auto [first, added] = firstVertices.emplace(vertices[v].pos, v);
+            positionIds[v] = first->second;
+            nextWedge[v] = added ? v : nextWedge[first->second];
+            nextWedge[first->second] = v;
+            wedgeCounts[first->second]++;
+        }
+
+        // an edge used by one triangle is open. It is on a seam if the edge between its positions is used twice,
+        // by the triangles either side of the seam, otherwise it's on the mesh's border
+        std::unordered_map<uint64_t, uint32_t> edgeCounts;
+        std::unordered_map<uint64_t, uint32_t> positionEdgeCounts;
+        auto edgeKey = [](uint32_t a, uint32_t b) {
+            return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+        };
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (uint32_t e = 0; e < 3; e++) {
+                uint32_t a = triangles[t * 3 + e], b = triangles[t * 3 + (e + 1) % 3];
+                edgeCounts[edgeKey(a, b)]++;
+                positionEdgeCounts[edgeKey(positionIds[a], positionIds[b])]++;
+            }
+        }
+
+        std::vector<bool> locked(vertexCount, false);
+        std::vector<uint32_t> seamEdgeCounts(vertexCount, 0);
+        for (const auto& [key, count] : edgeCounts) {
+            if (count != 1) continue;
+
+            uint32_t a = static_cast<uint32_t>(key >> 32), b = static_cast<uint32_t>(key & 0xFFFFFFFF);
+            if (positionEdgeCounts[edgeKey(positionIds[a], positionIds[b])] == 2) {
+                seamEdgeCounts[a]++;
+                seamEdgeCounts[b]++;
+            } else {
+                locked[a] = true;
+                locked[b] = true;
+            }
+        }
+
+        // a seam runs through a position with two wedges each on two seam edges, so those wedges can slide along it together.
+        // wedges where a seam ends, turns a corner or meets others are locked as they can't move without tearing
+        std::vector<bool> onSeam(vertexCount, false);
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            if (locked[v]) continue;
+
+            const uint32_t wedgeCount = wedgeCounts[positionIds[v]];
+            if (wedgeCount == 1) {
+                locked[v] = seamEdgeCounts[v] > 0;
+            } else if (wedgeCount == 2 && seamEdgeCounts[v] == 2 && seamEdgeCounts[nextWedge[v]] == 2 && !locked[nextWedge[v]]) {
+                onSeam[v] = true;
+            } else {
+                locked[v] = true;
+            }
+        }
+
+        // each position's quadric is the area weighted sum of the planes of every wedge's triangles, so large triangles count
+        // for more but the error is still averaged back to a distance. Both sides of a seam are measured against the whole surface
+        std::vector<Quadric> quadrics(vertexCount);
+        std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+        for (size_t t = 0; t < triangleCount; t++) {
+            const glm::vec3& p0 = vertices[triangles[t * 3 + 0]].pos;
+            const glm::vec3& p1 = vertices[triangles[t * 3 + 1]].pos;
+            const glm::vec3& p2 = vertices[triangles[t * 3 + 2]].pos;
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            if (area > 0.0f) {
+                normal /= area;
+                Quadric plane = Quadric::fromPlane(normal.x, normal.y, normal.z, -glm::dot(normal, p0), area * 0.5f);
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    quadrics[positionIds[triangles[t * 3 + corner]]].add(plane);
+                }
+            }
+
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                vertexTriangles[triangles[t * 3 + corner]].push_back(static_cast<uint32_t>(t));
+            }
+        }
+
+        std::vector<bool> removed(triangleCount, false);
+        std::vector<uint32_t> versions(vertexCount, 0);
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses;
+
+        // triangles still in the mesh that use the edge between two vertices
+        auto countEdge = [&](uint32_t a, uint32_t b) {
+            uint32_t count = 0;
+            for (uint32_t t : vertexTriangles[a]) {
+                const uint32_t* tri = &triangles[t * 3];
+                if (!removed[t] && (tri[0] == b || tri[1] == b || tri[2] == b)) count++;
+            }
+            return count;
+        };
+
+        auto pushCollapse = [&](uint32_t from, uint32_t to) {
+            if (locked[from] || from == to) return;
+
+            // seam wedges only move along the seam, to the vertex at the other end of one of their seam edges
+            if (onSeam[from] && (positionIds[from] == positionIds[to] || countEdge(from, to) != 1)) return;
+
+            Quadric combined = quadrics[positionIds[from]];
+            combined.add(quadrics[positionIds[to]]);
+            float cost = static_cast<float>(combined.error(vertices[to].pos));
+            collapses.push({ cost, from, to, versions[from], versions[to] });
+        };
+
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (uint32_t e = 0; e < 3; e++) {
+                uint32_t a = triangles[t * 3 + e], b = triangles[t * 3 + (e + 1) % 3];
+                pushCollapse(a, b);
+                pushCollapse(b, a);
+            }
+        }
+
+        // the wedge the other side of the seam moves onto when a seam wedge collapses, the wedge of the target's
+        // position at the other end of the matching seam edge. It can be the target itself where the seam closes up
+        auto findSeamTarget = [&](uint32_t from, uint32_t to, uint32_t& partnerTo) {
+            const uint32_t partner = nextWedge[from];
+            uint32_t wedge = to;
+            do {
+                if (countEdge(partner, wedge) == 1) {
+                    partnerTo = wedge;
+                    return true;
+                }
+                wedge = nextWedge[wedge];
+            } while (wedge != to);
+            return false;
+        };
+
+        // rejects collapses that would flip a triangle over
+        auto flipsTriangle = [&](uint32_t from, uint32_t to) {
+            for (uint32_t t : vertexTriangles[from]) {
+                if (removed[t]) continue;
+
+                const uint32_t* tri = &triangles[t * 3];
+                if (tri[0] == to || tri[1] == to || tri[2] == to) continue; // collapses to nothing
+
+                glm::vec3 p[3], moved[3];
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    p[corner] = vertices[tri[corner]].pos;
+                    moved[corner] = tri[corner] == from ? vertices[to].pos : p[corner];
+                }
+
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                if (glm::dot(before, after) <= 0.0f) return true;
+            }
+
+            return false;
+        };
+
+        const float maxCost = maxError * maxError;
+        size_t indexCount = triangleCount * 3;
+
+        // moves every triangle of the removed vertex onto the kept one, those sharing the edge become degenerate
+        auto moveTriangles = [&](uint32_t from, uint32_t to) {
+            for (uint32_t t : vertexTriangles[from]) {
+                if (removed[t]) continue;
+
+                uint32_t* tri = &triangles[t * 3];
+                if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                    removed[t] = true;
+                    indexCount -= 3;
+                    continue;
+                }
+
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    if (tri[corner] == from) tri[corner] = to;
+                }
+                vertexTriangles[to].push_back(t);
+            }
+            vertexTriangles[from].clear();
+        };
+
+        while (indexCount > targetIndexCount && !collapses.empty()) {
+            Collapse collapse = collapses.top();
+            collapses.pop();
+
+            // stale entries from before either vertex changed
+            if (collapse.fromVersion != versions[collapse.from] || collapse.toVersion != versions[collapse.to]) continue;
+            if (collapse.cost > maxCost) break;
+
+            // a seam wedge takes its other wedge with it, so the seam stays closed
+            const bool seam = onSeam[collapse.from];
+            const uint32_t partner = nextWedge[collapse.from];
+            uint32_t partnerTo = collapse.to;
+            if (seam && (countEdge(collapse.from, collapse.to) != 1 || !findSeamTarget(collapse.from, collapse.to, partnerTo))) continue;
+            if (flipsTriangle(collapse.from, collapse.to) || (seam && flipsTriangle(partner, partnerTo))) continue;
+
+            moveTriangles(collapse.from, collapse.to);
+            if (seam) moveTriangles(partner, partnerTo);
+
+            quadrics[positionIds[collapse.to]].add(quadrics[positionIds[collapse.from]]);
+            versions[collapse.from]++;
+            if (seam) versions[partner]++;
+            resultError = std::max(resultError, std::sqrt(collapse.cost));
+
+            // costs around every wedge of the kept position changed with its quadric
+            uint32_t kept = collapse.to;
+            do {
+                versions[kept]++;
+                kept = nextWedge[kept];
+            } while (kept != collapse.to);
+
+            do {
+                for (uint32_t t : vertexTriangles[kept]) {
+                    if (removed[t]) continue;
+
+                    for (uint32_t corner = 0; corner < 3; corner++) {
+                        uint32_t other = triangles[t * 3 + corner];
+                        if (other == kept) continue;
+
+                        pushCollapse(other, kept);
+                        pushCollapse(kept, other);
+                    }
+                }
+                kept = nextWedge[kept];
+            } while (kept != collapse.to);
+        }
+
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+        for (size_t t = 0; t < triangleCount; t++) {
+            if (removed[t]) continue;
+            result.insert(result.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+        }
+
+        return result;
+    }
+
+    void buildShortIndexSubmeshes(const std::vector<Vertex>& sourceVertices, const std::vector<uint32_t>& sourceIndices,
+                                  std::vector<Vertex>& vertices, std::vector<uint16_t>& indices, std::vector<Submesh>& submeshes) {
+        // whole mesh fits so the vertices can be used as is with a single submesh
+        if (sourceVertices.size() <= MAX_SUBMESH_VERTICES) {
+            Submesh submesh{};
+            submesh.firstIndex = static_cast<uint32_t>(indices.size());
+            submesh.indexCount = static_cast<uint32_t>(sourceIndices.size());
+            submesh.vertexOffset = static_cast<int32_t>(vertices.size());
+
+            vertices.insert(vertices.end(), sourceVertices.begin(), sourceVertices.end());
+            indices.reserve(indices.size() + sourceIndices.size());
+            for (uint32_t index : sourceIndices) {
+                indices.push_back(static_cast<uint16_t>(index));
+            }
+
+            submeshes.push_back(submesh);
+            return;
+        }
+
+        // maps a source vertex to its index in the submesh being built, UINT32_MAX if not yet used by it
+        std::vector<uint32_t> localIndex(sourceVertices.size(), UINT32_MAX);
+        std::vector<uint32_t> usedVertices;
+        usedVertices.reserve(MAX_SUBMESH_VERTICES);
+
+        Submesh current{};
+        current.firstIndex = static_cast<uint32_t>(indices.size());
+        current.vertexOffset = static_cast<int32_t>(vertices.size());
+
+        auto finishSubmesh = [&]() {
+            current.indexCount = static_cast<uint32_t>(indices.size()) - current.firstIndex;
+            if (current.indexCount > 0) {
+                submeshes.push_back(current);
+            }
+
+            for (uint32_t vertex : usedVertices) {
+                localIndex[vertex] = UINT32_MAX;
+            }
+            usedVertices.clear();
+
+            current.firstIndex = static_cast<uint32_t>(indices.size());
+            current.vertexOffset = static_cast<int32_t>(vertices.size());
+        };
+
+        for (size_t i = 0; i + 2 < sourceIndices.size(); i += 3) {
+            // count vertices of the triangle new to this submesh, start a new one if they don't fit
+            uint32_t newVertices = 0;
+            for (size_t corner = 0; corner < 3; corner++) {
+                if (localIndex[sourceIndices[i + corner]] == UINT32_MAX) newVertices++;
+            }
+
+            if (usedVertices.size() + newVertices > MAX_SUBMESH_VERTICES) {
+                finishSubmesh();
+            }
+
+            for (size_t corner = 0; corner < 3; corner++) {
+                uint32_t sourceIndex = sourceIndices[i + corner];
+                if (localIndex[sourceIndex] == UINT32_MAX) {
+                    localIndex[sourceIndex] = static_cast<uint32_t>(usedVertices.size());
+                    usedVertices.push_back(sourceIndex);
+                    vertices.push_back(sourceVertices[sourceIndex]);
+                }
+
+                indices.push_back(static_cast<uint16_t>(localIndex[sourceIndex]));
+            }
+        }
+
+        finishSubmesh();
+    }
+
+    void buildShortIndexLods(const std::vector<Vertex>& sourceVertices, const std::vector<std::vector<uint32_t>>& lodIndices,
+                             std::vector<Vertex>& vertices, std::vector<uint16_t>& indices, std::vector<MeshLod>& lods) {
+        if (sourceVertices.size() > MAX_SUBMESH_VERTICES) {
+            for (size_t lod = 0; lod < lodIndices.size(); lod++) {
+                buildShortIndexSubmeshes(sourceVertices, lodIndices[lod], vertices, indices, lods[lod].submeshes);
+            }
+            return;
+        }
+
+        // every level can index the same vertices
+        const int32_t vertexOffset = static_cast<int32_t>(vertices.size());
+        vertices.insert(vertices.end(), sourceVertices.begin(), sourceVertices.end());
+
+        for (size_t lod = 0; lod < lodIndices.size(); lod++) {
+            Submesh submesh{};
+            submesh.firstIndex = static_cast<uint32_t>(indices.size());
+            submesh.indexCount = static_cast<uint32_t>(lodIndices[lod].size());
+            submesh.vertexOffset = vertexOffset;
+
+            for (uint32_t index : lodIndices[lod]) {
+                indices.push_back(static_cast<uint16_t>(index));
+            }
+
+            lods[lod].submeshes.push_back(submesh);
+        }
+    }
+
+    void buildMeshlets(const std::vector<Vertex>& vertices, std::vector<uint16_t>& indices, const std::vector<Submesh>& submeshes,
+                       std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles) {
+        constexpr uint8_t unused = 0xFF;
+
+        for (const auto& submesh : submeshes) {
+            const uint32_t triangleCount = submesh.indexCount / 3;
+            if (triangleCount == 0) continue;
+
+            const uint16_t* submeshIndices = indices.data() + submesh.firstIndex;
+
+            uint32_t localVertexCount = 0;
+            for (uint32_t i = 0; i < submesh.indexCount; i++) {
+                localVertexCount = std::max(localVertexCount, static_cast<uint32_t>(submeshIndices[i]) + 1);
+            }
+
+            // triangles using each vertex, stored contiguously per vertex
+            std::vector<uint32_t> adjacencyOffsets(localVertexCount + 1, 0);
+            for (uint32_t i = 0; i < submesh.indexCount; i++) {
+                adjacencyOffsets[submeshIndices[i] + 1]++;
+            }
+            for (uint32_t v = 0; v < localVertexCount; v++) {
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            }
+
+            std::vector<uint32_t> adjacency(submesh.indexCount);
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (uint32_t i = 0; i < submesh.indexCount; i++) {
+                adjacency[fill[submeshIndices[i]]++] = i / 3;
+            }
+
+            std::vector<bool> emitted(triangleCount, false);
+            std::vector<uint8_t> localIndex(localVertexCount, unused);
+            std::vector<uint16_t> reordered;
+            reordered.reserve(submesh.indexCount);
+
+            std::vector<uint32_t> candidates;
+            uint32_t nextSeed = 0;
+
+            while (reordered.size() < submesh.indexCount) {
+                Meshlet meshlet{};
+                meshlet.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+                meshlet.triangleOffset = static_cast<uint32_t>(meshletTriangles.size() / 3);
+                meshlet.firstIndex = submesh.firstIndex + static_cast<uint32_t>(reordered.size());
+                meshlet.baseVertex = submesh.vertexOffset;
+
+                candidates.clear();
+
+                while (meshlet.triangleCount < MAX_MESHLET_TRIANGLES) {
+                    // pick the connected triangle adding the fewest new vertices
+                    uint32_t best = UINT32_MAX;
+                    uint32_t bestNewVertices = 4;
+                    for (uint32_t candidate : candidates) {
+                        if (emitted[candidate]) continue;
+
+                        uint32_t newVertices = 0;
+                        for (uint32_t corner = 0; corner < 3; corner++) {
+                            if (localIndex[submeshIndices[candidate * 3 + corner]] == unused) newVertices++;
+                        }
+
+                        if (newVertices < bestNewVertices) {
+                            best = candidate;
+                            bestNewVertices = newVertices;
+                        }
+                    }
+
+                    // nothing connected left so continue with the next unused triangle
+                    if (best == UINT32_MAX) {
+                        while (nextSeed < triangleCount && emitted[nextSeed]) nextSeed++;
+                        if (nextSeed == triangleCount) break;
+
+                        best = nextSeed;
+                        bestNewVertices = 0;
+                        for (uint32_t corner = 0; corner < 3; corner++) {
+                            if (localIndex[submeshIndices[best * 3 + corner]] == unused) bestNewVertices++;
+                        }
+                    }
+
+                    if (meshlet.vertexCount + bestNewVertices > MAX_MESHLET_VERTICES) break;
+
+                    emitted[best] = true;
+                    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](uint32_t t) { return emitted[t]; }), candidates.end());
+
+                    for (uint32_t corner = 0; corner < 3; corner++) {
+                        uint16_t vertex = submeshIndices[best * 3 + corner];
+                        if (localIndex[vertex] == unused) {
+                            localIndex[vertex] = static_cast<uint8_t>(meshlet.vertexCount++);
+                            meshletVertices.push_back(static_cast<uint32_t>(submesh.vertexOffset) + vertex);
+
+                            for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++) {
+                                if (!emitted[adjacency[a]]) candidates.push_back(adjacency[a]);
+                            }
+                        }
+
+                        meshletTriangles.push_back(localIndex[vertex]);
+                        reordered.push_back(vertex);
+                    }
+                    meshlet.triangleCount++;
+                }
+
+                // reset the local indices for the next meshlet
+                for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+                    localIndex[meshletVertices[meshlet.vertexOffset + i] - submesh.vertexOffset] = unused;
+                }
+
+                computeMeshletBounds(meshlet, vertices, meshletVertices, meshletTriangles);
+                meshlets.push_back(meshlet);
+            }
+
+            std::copy(reordered.begin(), reordered.end(), indices.begin() + submesh.firstIndex);
+        }
+    }
+}
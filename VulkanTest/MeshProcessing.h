@@ -0,0 +1,55 @@
+#pragma once
+#include "ModelData.h"
+#include <vector>
+
+/// <summary>
+/// CPU side processing of welded vertex and index data before it is uploaded to the GPU
+/// </summary>
+namespace MeshProcessing {
+	/// <summary>
+	/// Simplifies a triangle list with quadric error metric edge collapses. Vertices are only ever collapsed onto other
+	/// existing vertices so the result indexes the same vertex array. Vertices on mesh borders are locked, vertices on
+	/// attribute seams only collapse along the seam together with their wedge on the other side so the seam never tears
+	/// </summary>
+	/// <param name="vertices">Welded vertices the indices refer to</param>
+	/// <param name="indices">Triangle list to simplify</param>
+	/// <param name="targetIndexCount">Stops once the index count reaches this</param>
+	/// <param name="maxError">Stops before any collapse would move the surface further than this, in model units</param>
+	/// <param name="resultError">Set to the largest error of the collapses made, a distance in model units</param>
+	std::vector<uint32_t> simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float& resultError);
+
+	/// <summary>
+	/// Converts 32 bit indices to 16 bit indices, splitting the mesh into submeshes when it references more
+	/// vertices than a 16 bit index can address. Each submesh gets its own copy of the vertices it uses
+	/// so its indices can be offset by a base vertex when drawn
+	/// </summary>
+	/// <param name="sourceVertices">Welded vertices the source indices refer to</param>
+	/// <param name="sourceIndices">Triangle list indices into sourceVertices</param>
+	/// <param name="vertices">Vertices referenced by the output submeshes, appended to</param>
+	/// <param name="indices">16 bit indices relative to each submesh's vertex offset, appended to</param>
+	/// <param name="submeshes">Ranges of the output to draw, appended to</param>
+	void buildShortIndexSubmeshes(const std::vector<Vertex>& sourceVertices, const std::vector<uint32_t>& sourceIndices,
+								  std::vector<Vertex>& vertices, std::vector<uint16_t>& indices, std::vector<Submesh>& submeshes);
+
+	/// <summary>
+	/// Converts every level of detail to 16 bit submeshes. When the source vertices fit in a single submesh
+	/// all levels share one copy of them, otherwise each level is split separately
+	/// </summary>
+	/// <param name="lodIndices">Triangle list indices into sourceVertices for each level, most detailed first</param>
+	/// <param name="lods">Levels to fill in the submeshes of, must be the same size as lodIndices</param>
+	void buildShortIndexLods(const std::vector<Vertex>& sourceVertices, const std::vector<std::vector<uint32_t>>& lodIndices,
+							 std::vector<Vertex>& vertices, std::vector<uint16_t>& indices, std::vector<MeshLod>& lods);
+
+	/// <summary>
+	/// Partitions each submesh into meshlets of at most MAX_MESHLET_VERTICES vertices and MAX_MESHLET_TRIANGLES triangles,
+	/// reordering the submesh's triangles so each meshlet is also a contiguous range of the index buffer
+	/// </summary>
+	/// <param name="vertices">Vertices the submeshes refer to</param>
+	/// <param name="indices">16 bit indices of the submeshes, reordered in place</param>
+	/// <param name="submeshes">Submeshes to partition</param>
+	/// <param name="meshlets">Generated meshlets with their culling bounds, appended to</param>
+	/// <param name="meshletVertices">Indices into vertices for each meshlet vertex, appended to</param>
+	/// <param name="meshletTriangles">Three meshlet local vertex indices per triangle, appended to</param>
+	void buildMeshlets(const std::vector<Vertex>& vertices, std::vector<uint16_t>& indices, const std::vector<Submesh>& submeshes,
+					   std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles);
+}
@@ -1,81 +1,179 @@
 #include "Model.h"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
+#include <cstring>
 
 #include "LogicalDevice.h"
 #include "PhysicalDevice.h"
 #include "Buffer.h"
+#include "MeshCache.h"
+#include "MeshCooker.h"
 #include "Debug.h"
 
-Model::Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, std::string path) {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
+Model::Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool,
+             const std::unique_ptr<GeometryBuffer>& geometryBuffer, std::string path)
+    : Model(device, physicalDevice, path) {
+    upload(device, physicalDevice, graphicsPool, transferPool, geometryBuffer);
+}
 
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str())) {
-        Debug::exception(warn + err);
+Model::Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, std::string path) {
+    // cooked meshes are cached so only the first run after the source changes pays for processing
+    MeshCacheData cache;
+    if (MeshCache::read(path, cache)) {
+        if (loadCache(cache, device, physicalDevice)) {
+            createMeshletBuffers(device, physicalDevice);
+            return;
+        }
+        stagedBuffers.clear();
+        stagedVertices.reset();
+        stagedIndices.reset();
+        Debug::log("mesh cache for " + path + " is corrupt, cooking the source");
     }
 
-    std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+    cache = MeshCooker::cookObj(path);
 
-    for (const auto& shape : shapes) {
-        for (const auto& index : shape.mesh.indices) {
-            Vertex vertex{};
+    // not being able to cache only costs load time, so carry on without one
+    if (!MeshCache::write(path, cache)) {
+        Debug::log("failed to write mesh cache for " + path);
+    }
 
-            vertex.pos = {
-                attrib.vertices[3 * index.vertex_index + 0],
-                attrib.vertices[3 * index.vertex_index + 1],
-                attrib.vertices[3 * index.vertex_index + 2]
-            };
+    stageCache(device, physicalDevice, cache);
+}
 
-            vertex.texCoord = {
-                attrib.texcoords[2 * index.texcoord_index + 0],
-                1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-            };
+Model::Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const MeshCacheData& cache) {
+    stageCache(device, physicalDevice, cache);
+}
 
-            vertex.color = { 1.0f, 1.0f, 1.0f };
+Model::Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::vector<Vertex>& meshVertices, const std::vector<uint32_t>& meshIndices) {
+    stageCache(device, physicalDevice, MeshCooker::cookMesh(meshVertices, meshIndices));
+}
 
-            if (uniqueVertices.count(vertex) == 0) {
-                uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                vertices.push_back(vertex);
-            }
+Model::~Model() {
+    if (geometryBuffer) geometryBuffer->free(geometry);
+}
 
-            indices.push_back(uniqueVertices[vertex]);
-        }
+void Model::upload(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool,
+                   const std::unique_ptr<GeometryBuffer>& geometryBuffer) {
+    // the vertices and indices share the geometry buffer with every other model, addressed by their range of it
+    geometry = geometryBuffer->allocate(vertexCount, indexCount);
+    this->geometryBuffer = geometryBuffer.get();
+    geometryBuffer->upload(graphicsPool, transferPool, geometry, stagedVertices, stagedIndices);
+    stagedVertices.reset();
+    stagedIndices.reset();
+
+    for (auto& staged : stagedBuffers) {
+        auto buffer = std::make_unique<Buffer>(device, physicalDevice, staged.size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | staged.usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        buffer->copyFromBuffer(physicalDevice, graphicsPool, transferPool, staged.stagingBuffer);
+        *staged.destination = std::move(buffer);
     }
+    stagedBuffers.clear();
+}
 
-    createVertexBuffer(device, physicalDevice, graphicsPool, transferPool);
-    createIndexBuffer(device, physicalDevice, graphicsPool, transferPool);
+bool Model::loadCache(const MeshCacheData& cache, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice) {
+    stagedVertices = createStagingBuffer(device, physicalDevice, sizeof(Vertex) * cache.vertexCount, [&](void* mapped) {
+        return MeshCache::decodeVertices(cache, static_cast<Vertex*>(mapped));
+    });
+    stagedIndices = createStagingBuffer(device, physicalDevice, sizeof(uint16_t) * cache.indexCount, [&](void* mapped) {
+        return MeshCache::decodeIndices(cache, static_cast<uint16_t*>(mapped));
+    });
+    if (!stagedVertices || !stagedIndices) return false;
+
+    vertexCount = cache.vertexCount;
+    indexCount = cache.indexCount;
+
+    lods = cache.lods;
+    sourceSize = cache.sourceSize;
+    sourceHash = cache.sourceHash;
+    boundsCenter = cache.boundsCenter;
+    boundsRadius = cache.boundsRadius;
+    meshlets = cache.meshlets;
+    meshletVertices = cache.meshletVertices;
+    meshletTriangles = cache.meshletTriangles;
+    return true;
 }
 
-void Model::draw(VkCommandBuffer cmdBuffer) {
-    const std::array<VkDeviceSize, 1> offsets = { 0 };
-    const std::array<VkBuffer, 1> buffers = { vertexBuffer->getBuffer() };
-    vkCmdBindVertexBuffers(cmdBuffer, 0, static_cast<uint32_t>(buffers.size()), buffers.data(), offsets.data());
-    vkCmdBindIndexBuffer(cmdBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+void Model::stageCache(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const MeshCacheData& cache) {
+    if (!loadCache(cache, device, physicalDevice)) {
+        Debug::exception("failed to decode mesh cache");
+    }
+    createMeshletBuffers(device, physicalDevice);
+}
 
-    // Draw command for the triangle
-    vkCmdDrawIndexed(cmdBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+void Model::addDrawCommands(std::vector<VkDrawIndexedIndirectCommand>& commands, const glm::vec3& cameraPosition, float projectionScale, uint32_t instanceCount) const {
+    // one draw per submesh, each offset to the vertices its 16 bit indices refer to and drawing every instance
+    const MeshLod& lod = lods[selectLod(cameraPosition, projectionScale)];
+    for (const auto& submesh : lod.submeshes) {
+        VkDrawIndexedIndirectCommand command{};
+        command.indexCount = submesh.indexCount;
+        command.instanceCount = instanceCount;
+        command.firstIndex = geometry.firstIndex + submesh.firstIndex;
+        command.vertexOffset = static_cast<int32_t>(geometry.firstVertex) + submesh.vertexOffset;
+        command.firstInstance = 0;
+        commands.push_back(command);
+    }
 }
 
-void Model::createVertexBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool) {
-    VkDeviceSize size = sizeof(vertices[0]) * vertices.size();
+uint32_t Model::selectLod(const glm::vec3& cameraPosition, float projectionScale) const {
+    // distance to the nearest point of the bounds, inside them always uses full detail
+    float distance = glm::distance(cameraPosition, boundsCenter) - boundsRadius;
+    if (distance <= 0.0f) return 0;
 
-    auto stagingBuffer = std::make_unique<Buffer>(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-    stagingBuffer->copyFromData(vertices.data());
+    // pick the coarsest level whose error projects to less than the allowed number of pixels
+    uint32_t lod = 0;
+    for (uint32_t i = 1; i < lods.size(); i++) {
+        if (lods[i].error / distance * projectionScale > MAX_LOD_PIXEL_ERROR) break;
+        lod = i;
+    }
 
-    vertexBuffer = std::make_unique<Buffer>(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    vertexBuffer->copyFromBuffer(physicalDevice, graphicsPool, transferPool, stagingBuffer);
+    return lod;
 }
 
-void Model::createIndexBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool) {
-    VkDeviceSize size = sizeof(indices[0]) * indices.size();
+const VkBuffer Model::getMeshletBuffer() const {
+    return meshletBuffer->getBuffer();
+}
 
-    auto stagingBuffer = std::make_unique<Buffer>(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-    stagingBuffer->copyFromData(indices.data());
+const VkBuffer Model::getMeshletVertexBuffer() const {
+    return meshletVertexBuffer->getBuffer();
+}
+
+const VkBuffer Model::getMeshletTriangleBuffer() const {
+    return meshletTriangleBuffer->getBuffer();
+}
+
+void Model::createMeshletBuffers(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice) {
+    // storage buffers so compute culling or mesh shaders can read the meshlets directly
+    stageBuffer(device, physicalDevice, meshlets.data(), sizeof(meshlets[0]) * meshlets.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshletBuffer);
+    stageBuffer(device, physicalDevice, meshletVertices.data(), sizeof(meshletVertices[0]) * meshletVertices.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshletVertexBuffer);
+
+    // shaders read the triangles as uints so pad to a multiple of 4 bytes
+    meshletTriangles.resize((meshletTriangles.size() + 3) & ~size_t(3), 0);
+    stageBuffer(device, physicalDevice, meshletTriangles.data(), meshletTriangles.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshletTriangleBuffer);
+}
 
-    indexBuffer = std::make_unique<Buffer>(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    indexBuffer->copyFromBuffer(physicalDevice, graphicsPool, transferPool, stagingBuffer);
+void Model::stageBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const void* data, VkDeviceSize size, VkBufferUsageFlags usage, std::unique_ptr<Buffer>& destination) {
+    stageBuffer(device, physicalDevice, size, usage, destination, [&](void* mapped) {
+        std::memcpy(mapped, data, static_cast<size_t>(size));
+        return true;
+    });
 }
+
+bool Model::stageBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, std::unique_ptr<Buffer>& destination,
+                        const std::function<bool(void*)>& fill) {
+    auto stagingBuffer = createStagingBuffer(device, physicalDevice, size, fill);
+    if (!stagingBuffer) return false;
+
+    stagedBuffers.push_back({ std::move(stagingBuffer), size, usage, &destination });
+    return true;
+}
+
+std::unique_ptr<Buffer> Model::createStagingBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, VkDeviceSize size,
+                                                   const std::function<bool(void*)>& fill) {
+    auto stagingBuffer = std::make_unique<Buffer>(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+
+    void* mapped;
+    stagingBuffer->mapMemory(&mapped);
+    bool filled = fill(mapped);
+    stagingBuffer->unmapMemory();
+    if (!filled) return nullptr;
+
+    return stagingBuffer;
+}
\ No newline at end of file
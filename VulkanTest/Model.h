@@ -1,32 +1,165 @@
 #pragma once
 #include "ModelData.h"
+#include "GeometryBuffer.h"
 #include <memory>
 #include <chrono>
+#include <functional>
 #include <vector>
 #include <string>
 #include <unordered_map>
 
 class Buffer;
 class CommandPool;
+struct MeshCacheData;
 class LogicalDevice;
 class PhysicalDevice;
 
 // @TODO NEED DESCRIPTOR SET PER MODEL
 class Model {
 public:
-	Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, std::string path);
+	Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool,
+		  const std::unique_ptr<GeometryBuffer>& geometryBuffer, std::string path);
 
-	void draw(VkCommandBuffer cmdBuffer);
+	/// <summary>
+	/// Loads the model's mesh cache into staging buffers without recording any commands, so is safe to call
+	/// from any thread. Sources the AssetCooker hasn't cooked yet are cooked first. upload must be called before the model is drawn
+	/// </summary>
+	Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, std::string path);
+
+	/// <summary>
+	/// Stages an already processed mesh, such as a cache read from an AssetPack, see the staging constructor from a path
+	/// </summary>
+	Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const MeshCacheData& cache);
+
+	/// <summary>
+	/// Cooks an already welded mesh into staging buffers, see the staging constructor from a path
+	/// </summary>
+	Model(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::vector<Vertex>& meshVertices, const std::vector<uint32_t>& meshIndices);
+
+	/// <summary>
+	/// Frees the model's room in the geometry buffer, so only destroy it once no frame in flight draws it
+	/// </summary>
+	~Model();
+
+	/// <summary>
+	/// Copies the vertices and indices into the geometry buffer and the rest of the staging buffers into device local buffers, then frees them
+	/// </summary>
+	void upload(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool,
+				const std::unique_ptr<GeometryBuffer>& geometryBuffer);
+	const bool isUploaded() const { return stagedBuffers.empty() && !stagedVertices; }
+
+	/// <summary>
+	/// Adds the draws of the level of detail suited to how large the model appears on screen, addressing its range of the
+	/// geometry buffer so the draws of every model can be made at once, see GeometryBuffer::drawIndirect
+	/// </summary>
+	/// <param name="cameraPosition">Camera position in the model's local space</param>
+	/// <param name="projectionScale">Pixels per unit at distance 1, the viewport height / (2 * tan(fovY / 2))</param>
+	/// <param name="instanceCount">Instances drawn, all at the level of detail picked from cameraPosition so give it in the nearest instance's space.
+	/// Their data is bound separately, see InstanceBuffer</param>
+	void addDrawCommands(std::vector<VkDrawIndexedIndirectCommand>& commands, const glm::vec3& cameraPosition, float projectionScale, uint32_t instanceCount = 1) const;
+
+	/// <summary>
+	/// Picks the coarsest level of detail whose error on screen stays under MAX_LOD_PIXEL_ERROR
+	/// </summary>
+	uint32_t selectLod(const glm::vec3& cameraPosition, float projectionScale) const;
+
+	const VkBuffer getMeshletBuffer() const;
+	const VkBuffer getMeshletVertexBuffer() const;
+	const VkBuffer getMeshletTriangleBuffer() const;
+	const uint32_t getMeshletCount() const { return static_cast<uint32_t>(meshlets.size()); }
+	const uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); }
+
+	/// <summary>
+	/// Size and ContentHash of the source file the model was cooked from, see MeshCacheData
+	/// </summary>
+	const uint64_t getSourceSize() const { return sourceSize; }
+	const uint64_t getSourceHash() const { return sourceHash; }
+
+	/// <summary>
+	/// How many pixels a level of detail's error may cover before a more detailed level is used
+	/// </summary>
+	static constexpr float MAX_LOD_PIXEL_ERROR = 1.0f;
 
 private:
-	void createVertexBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool);
-	void createIndexBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool);
+	/// <summary>
+	/// Stages the buffers from a mesh cache, throwing if it can't be decoded
+	/// </summary>
+	void stageCache(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const MeshCacheData& cache);
+
+	/// <summary>
+	/// Stages the buffers from a mesh cache, decoding the vertices and indices straight into staging memory
+	/// </summary>
+	/// <returns>False if the cached data couldn't be decoded</returns>
+	bool loadCache(const MeshCacheData& cache, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice);
+
+	void createMeshletBuffers(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice);
+
+	/// <summary>
+	/// Makes a host visible staging buffer filled by writing to its mapped memory
+	/// </summary>
+	/// <param name="fill">Writes size bytes to the mapped memory, returning false if it couldn't</param>
+	/// <returns>Null if fill failed</returns>
+	std::unique_ptr<Buffer> createStagingBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, VkDeviceSize size,
+												const std::function<bool(void*)>& fill);
+
+	/// <summary>
+	/// Copies data into a staging buffer to become a device local buffer on upload
+	/// </summary>
+	void stageBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const void* data, VkDeviceSize size, VkBufferUsageFlags usage, std::unique_ptr<Buffer>& destination);
+
+	/// <summary>
+	/// Fills a staging buffer by writing to its mapped memory, to become a device local buffer on upload
+	/// </summary>
+	/// <param name="fill">Writes size bytes to the mapped memory, returning false if it couldn't</param>
+	/// <returns>False if fill failed, leaving nothing staged</returns>
+	bool stageBuffer(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, std::unique_ptr<Buffer>& destination,
+					 const std::function<bool(void*)>& fill);
+
+	struct StagedBuffer {
+		std::unique_ptr<Buffer> stagingBuffer;
+		VkDeviceSize size;
+		VkBufferUsageFlags usage;
+
+		/// <summary>
+		/// Member the device local buffer is put in once uploaded
+		/// </summary>
+		std::unique_ptr<Buffer>* destination;
+	};
 
 private:
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
+	std::vector<MeshLod> lods;
+
+	uint64_t sourceSize = 0;
+	uint64_t sourceHash = 0;
+
+	glm::vec3 boundsCenter;
+	float boundsRadius;
+
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint8_t> meshletTriangles;
+
+	/// <summary>
+	/// Vertices and indices waiting for upload to copy them into the geometry buffer
+	/// </summary>
+	std::unique_ptr<Buffer> stagedVertices;
+	std::unique_ptr<Buffer> stagedIndices;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+
+	/// <summary>
+	/// The model's range of the geometry buffer, null until uploaded
+	/// </summary>
+	GeometryBuffer* geometryBuffer = nullptr;
+	GeometryAllocation geometry;
+
+	std::unique_ptr<Buffer> meshletBuffer;
+	std::unique_ptr<Buffer> meshletVertexBuffer;
+	std::unique_ptr<Buffer> meshletTriangleBuffer;
 
-	std::unique_ptr<Buffer> vertexBuffer;
-	std::unique_ptr<Buffer> indexBuffer;
+	/// <summary>
+	/// Buffers waiting for upload to copy them to the device
+	/// </summary>
+	std::vector<StagedBuffer> stagedBuffers;
 };
 
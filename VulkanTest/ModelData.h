@@ -7,48 +7,117 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+#include "VertexLayout.h"
+
 #include <array>
+#include <limits>
+#include <vector>
 
-struct Vertex {
-    glm::vec3 pos;
-    glm::vec3 color;
-    glm::vec2 texCoord;
+/// <summary>
+/// Largest number of unique vertices a submesh can reference with 16 bit indices
+/// </summary>
+constexpr uint32_t MAX_SUBMESH_VERTICES = static_cast<uint32_t>(std::numeric_limits<uint16_t>::max()) + 1;
+
+/// <summary>
+/// Range of the index buffer drawn in one call, indices are relative to vertexOffset
+/// </summary>
+struct Submesh {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+};
 
-    static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription bindingDesc{};
+constexpr uint32_t MAX_LOD_COUNT = 4;
 
-        bindingDesc.binding = 0;
-        bindingDesc.stride = sizeof(Vertex);
-        bindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+/// <summary>
+/// Fraction of the previous level's triangles each level of detail is simplified down to
+/// </summary>
+constexpr float LOD_REDUCTION = 0.5f;
 
-        return bindingDesc;
-    }
+/// <summary>
+/// One level of detail, all levels share the model's vertex buffer where possible
+/// </summary>
+struct MeshLod {
+    std::vector<Submesh> submeshes;
+
+    /// <summary>
+    /// Largest distance in model units the simplified surface deviates from the original
+    /// </summary>
+    float error;
+};
+
+constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+/// <summary>
+/// Small cluster of a mesh's triangles with bounds used to cull it, laid out to match std430 for storage buffers
+/// </summary>
+struct Meshlet {
+    // bounding sphere
+    glm::vec3 center;
+    float radius;
 
-    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 3> attributeDesc{};
+    // normal cone, the meshlet is back facing when dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff
+    glm::vec3 coneAxis;
+    float coneCutoff;
+    glm::vec3 coneApex;
 
-        attributeDesc[0].binding = 0;
-        attributeDesc[0].location = 0;
-        attributeDesc[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDesc[0].offset = offsetof(Vertex, pos);
+    // ranges into the meshlet vertex and triangle buffers, used by mesh shaders
+    uint32_t vertexOffset;
+    uint32_t triangleOffset;
+    uint32_t vertexCount;
+    uint32_t triangleCount;
 
-        attributeDesc[1].binding = 0;
-        attributeDesc[1].location = 1;
-        attributeDesc[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDesc[1].offset = offsetof(Vertex, color);
+    // range of the model's index buffer holding the same triangles, used for indexed draws
+    uint32_t firstIndex;
+    int32_t baseVertex;
 
-        attributeDesc[2].binding = 0;
-        attributeDesc[2].location = 2;
-        attributeDesc[2].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDesc[2].offset = offsetof(Vertex, texCoord);
+    uint32_t padding[3];
+};
+
+struct Vertex {
+    glm::vec3 pos;
+    glm::vec3 color;
+    glm::vec2 texCoord;
 
-        return attributeDesc;
+    /// <summary>
+    /// Fields read by the vertex shader in location order, see VertexLayout
+    /// </summary>
+    static constexpr auto getFields() {
+        return std::array{
+            VERTEX_FIELD(Vertex, pos),
+            VERTEX_FIELD(Vertex, color),
+            VERTEX_FIELD(Vertex, texCoord)
+        };
     }
+
     bool operator==(const Vertex& other) const {
         return pos == other.pos && color == other.color && texCoord == other.texCoord;
     }
 };
 
+/// <summary>
+/// Per instance vertex input, read once per instance from its own binding so a model is drawn many times in one call
+/// </summary>
+struct InstanceData {
+    glm::mat4 model;
+
+    /// <summary>
+    /// Multiplies the vertex colour
+    /// </summary>
+    glm::vec4 color;
+
+    /// <summary>
+    /// Fields read by the vertex shader in location order, following Vertex's, see VertexLayout
+    /// </summary>
+    static constexpr auto getFields() {
+        return std::array{
+            VERTEX_FIELD(InstanceData, model),
+            VERTEX_FIELD(InstanceData, color)
+        };
+    }
+};
+
 // for map
 namespace std {
     template<> struct hash<Vertex> {
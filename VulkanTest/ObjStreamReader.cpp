@@ -0,0 +1,298 @@
+#include "ObjStreamReader.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+    /// <summary>
+    /// Splits off the next whitespace separated token, empty if there are none left
+    /// </summary>
+    std::string_view nextToken(std::string_view& text) {
+        size_t start = text.find_first_not_of(" \t\r");
+        if (start == std::string_view::npos) {
+            text = {};
+            return {};
+        }
+
+        size_t end = text.find_first_of(" \t\r", start);
+        if (end == std::string_view::npos) end = text.size();
+
+        std::string_view token = text.substr(start, end - start);
+        text.remove_prefix(end);
+        return token;
+    }
+
+    float parseFloat(std::string_view token) {
+        float value = 0.0f;
+        std::from_chars(token.data(), token.data() + token.size(), value);
+        return value;
+    }
+
+    /// <summary>
+    /// Converts a one based OBJ index, or negative index relative to the end, to a zero based index
+    /// </summary>
+    uint32_t resolveIndex(std::string_view token, size_t count) {
+        int64_t index = 0;
+        std::from_chars(token.data(), token.data() + token.size(), index);
+
+        int64_t resolved = index < 0 ? static_cast<int64_t>(count) + index : index - 1;
+        if (index == 0 || resolved < 0 || resolved >= static_cast<int64_t>(count)) {
+            Debug::exception("obj face refers to a vertex that doesn't exist");
+        }
+
+        return static_cast<uint32_t>(resolved);
+    }
+
+    bool seekFile(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+        return _fseeki64(file, static_cast<int64_t>(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+}
+
+template<typename T>
+ObjStreamReader::AttributeStore<T>::AttributeStore(size_t memoryBudget) :
+    // the page being appended to and one page faces refer back to, at the least
+    maxResidentPages(std::max<size_t>(memoryBudget / PAGE_BYTES, 2)) {
+}
+
+template<typename T>
+ObjStreamReader::AttributeStore<T>::~AttributeStore() {
+    if (spillFile) std::fclose(spillFile);
+}
+
+template<typename T>
+void ObjStreamReader::AttributeStore<T>::push_back(const T& value) {
+    if (count % PAGE_VALUES == 0) {
+        if (residentPages == maxResidentPages) evictPage();
+
+        Page& page = pages.emplace_back();
+        page.values.reserve(PAGE_VALUES);
+        page.lastUsed = ++useCount;
+        residentPages++;
+    }
+
+    pages.back().values.push_back(value);
+    count++;
+}
+
+template<typename T>
+const T ObjStreamReader::AttributeStore<T>::get(size_t index) {
+    const size_t pageIndex = index / PAGE_VALUES;
+    if (pages[pageIndex].values.empty()) {
+        if (residentPages == maxResidentPages) evictPage();
+
+        // only full pages are spilled
+        Page& page = pages[pageIndex];
+        page.values.resize(PAGE_VALUES);
+        if (!seekFile(spillFile, pageIndex * PAGE_VALUES * sizeof(T)) || std::fread(page.values.data(), sizeof(T), PAGE_VALUES, spillFile) != PAGE_VALUES) {
+            Debug::exception("failed to read spilled obj attributes");
+        }
+        residentPages++;
+    }
+
+    Page& page = pages[pageIndex];
+    page.lastUsed = ++useCount;
+    return page.values[index % PAGE_VALUES];
+}
+
+template<typename T>
+void ObjStreamReader::AttributeStore<T>::evictPage() {
+    // the last page is still being appended to so it always stays
+    Page* leastRecent = nullptr;
+    for (size_t i = 0; i + 1 < pages.size(); i++) {
+        if (!pages[i].values.empty() && (!leastRecent || pages[i].lastUsed < leastRecent->lastUsed)) leastRecent = &pages[i];
+    }
+    if (!leastRecent) return;
+
+    // pages never change once full, so a page is only written the first time it is evicted
+    if (!leastRecent->spilled) {
+        if (!spillFile) {
+            spillFile = std::tmpfile();
+            if (!spillFile) Debug::exception("failed to create a temporary file to spill obj attributes to");
+        }
+
+        const size_t pageIndex = leastRecent - pages.data();
+        if (!seekFile(spillFile, pageIndex * PAGE_VALUES * sizeof(T)) || std::fwrite(leastRecent->values.data(), sizeof(T), PAGE_VALUES, spillFile) != PAGE_VALUES) {
+            Debug::exception("failed to spill obj attributes");
+        }
+        leastRecent->spilled = true;
+    }
+
+    std::vector<T>().swap(leastRecent->values);
+    residentPages--;
+}
+
+ObjStreamReader::ObjStreamReader(const std::string& path, const ObjStreamConfig& config) :
+    file(path, std::ios::binary),
+    config(config),
+    positions(config.attributeMemoryBudget / 2),
+    texCoords(config.attributeMemoryBudget / 2) {
+    if (!file.is_open()) {
+        Debug::exception("failed to open obj file");
+    }
+
+    if (config.weldWindowVertices < 3 || config.weldWindowVertices > MAX_SUBMESH_VERTICES || config.readChunkSize == 0) {
+        Debug::exception("invalid obj streaming config");
+    }
+
+    chunk.resize(config.readChunkSize);
+}
+
+bool ObjStreamReader::nextBatch(MeshBatch& batch) {
+    batch.vertices.clear();
+    batch.indices.clear();
+    weldedVertices.clear();
+
+    if (!pendingFace.empty()) {
+        std::string face = std::move(pendingFace);
+        pendingFace.clear();
+
+        if (!addFace(face, batch)) {
+            Debug::exception("obj face has more vertices than the weld window");
+        }
+    }
+
+    std::string_view line;
+    while (readLine(line)) {
+        std::string_view keyword = nextToken(line);
+
+        if (keyword == "v") {
+            parsePosition(line);
+        } else if (keyword == "vt") {
+            parseTexCoord(line);
+        } else if (keyword == "f" && !addFace(line, batch)) {
+            // batch is full, keep the face for the next one
+            pendingFace = std::string(line);
+            return true;
+        }
+    }
+
+    return !batch.indices.empty();
+}
+
+bool ObjStreamReader::readLine(std::string_view& line) {
+    spanningLine.clear();
+    bool spanning = false;
+
+    while (true) {
+        if (chunkStart == chunkEnd) {
+            if (!file) {
+                // last line of the file without a newline
+                line = spanningLine;
+                return spanning;
+            }
+
+            file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            chunkStart = 0;
+            chunkEnd = static_cast<size_t>(file.gcount());
+
+            // hashed as it is read so the source never has to be read again to identify it
+            contentHash = ContentHash::hash(chunk.data(), chunkEnd, contentHash);
+            bytesRead += chunkEnd;
+            continue;
+        }
+
+        const char* begin = chunk.data() + chunkStart;
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', chunkEnd - chunkStart));
+
+        if (newline == nullptr) {
+            spanningLine.append(begin, chunkEnd - chunkStart);
+            spanning = true;
+            chunkStart = chunkEnd;
+            continue;
+        }
+
+        size_t length = newline - begin;
+        chunkStart += length + 1;
+
+        if (spanning) {
+            spanningLine.append(begin, length);
+            line = spanningLine;
+        } else {
+            line = std::string_view(begin, length);
+        }
+        return true;
+    }
+}
+
+bool ObjStreamReader::addFace(std::string_view face, MeshBatch& batch) {
+    faceCorners.clear();
+    uint32_t newVertices = 0;
+
+    // resolve every corner before adding any so a face that doesn't fit leaves the batch untouched
+    for (std::string_view corner = nextToken(face); !corner.empty(); corner = nextToken(face)) {
+        size_t slash = corner.find('/');
+        uint32_t positionIndex = resolveIndex(corner.substr(0, slash), positions.size());
+
+        uint32_t texCoordIndex = UINT32_MAX;
+        if (slash != std::string_view::npos) {
+            std::string_view texCoord = corner.substr(slash + 1);
+            texCoord = texCoord.substr(0, texCoord.find('/'));
+            if (!texCoord.empty()) {
+                texCoordIndex = resolveIndex(texCoord, texCoords.size());
+            }
+        }
+
+        uint64_t key = (static_cast<uint64_t>(positionIndex) << 32) | texCoordIndex;
+        if (weldedVertices.count(key) == 0 && std::find(faceCorners.begin(), faceCorners.end(), key) == faceCorners.end()) {
+            newVertices++;
+        }
+        faceCorners.push_back(key);
+    }
+
+    if (faceCorners.size() < 3) return true; // points and lines have nothing to draw
+
+    if (batch.vertices.size() + newVertices > config.weldWindowVertices) return false;
+
+    std::vector<uint16_t> cornerIndices(faceCorners.size());
+    for (size_t i = 0; i < faceCorners.size(); i++) {
+        uint64_t key = faceCorners[i];
+
+        auto welded = weldedVertices.find(key);
+        if (welded != weldedVertices.end()) {
+            cornerIndices[i] = welded->second;
+            continue;
+        }
+
+        uint32_t positionIndex = static_cast<uint32_t>(key >> 32);
+        uint32_t texCoordIndex = static_cast<uint32_t>(key & 0xFFFFFFFF);
+
+        Vertex vertex{};
+        vertex.pos = positions.get(positionIndex);
+        vertex.texCoord = texCoordIndex == UINT32_MAX ? glm::vec2(0.0f) : texCoords.get(texCoordIndex);
+        vertex.color = { 1.0f, 1.0f, 1.0f };
+
+        cornerIndices[i] = static_cast<uint16_t>(batch.vertices.size());
+        weldedVertices[key] = cornerIndices[i];
+        batch.vertices.push_back(vertex);
+    }
+
+    // polygons are triangulated as a fan around their first corner
+    for (size_t i = 1; i + 1 < cornerIndices.size(); i++) {
+        batch.indices.push_back(cornerIndices[0]);
+        batch.indices.push_back(cornerIndices[i]);
+        batch.indices.push_back(cornerIndices[i + 1]);
+    }
+
+    return true;
+}
+
+void ObjStreamReader::parsePosition(std::string_view values) {
+    glm::vec3 position;
+    position.x = parseFloat(nextToken(values));
+    position.y = parseFloat(nextToken(values));
+    position.z = parseFloat(nextToken(values));
+    positions.push_back(position);
+}
+
+void ObjStreamReader::parseTexCoord(std::string_view values) {
+    glm::vec2 texCoord;
+    texCoord.x = parseFloat(nextToken(values));
+    texCoord.y = 1.0f - parseFloat(nextToken(values)); // flip to match vulkan's top left origin
+    texCoords.push_back(texCoord);
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "ModelData.h"
+#include "ContentHash.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Limits on how much of an OBJ file is held in memory at once while streaming it
+/// </summary>
+struct ObjStreamConfig {
+	/// <summary>
+	/// Bytes read from the file per read call
+	/// </summary>
+	size_t readChunkSize = 1 << 20;
+
+	/// <summary>
+	/// Unique vertices welded together before a batch is emitted, at most MAX_SUBMESH_VERTICES so batches can use 16 bit indices
+	/// </summary>
+	uint32_t weldWindowVertices = MAX_SUBMESH_VERTICES;
+
+	/// <summary>
+	/// Bytes of positions and texture coordinates held in memory, half for each. Past it the least recently used pages
+	/// are spilled to a temporary file and read back when a face refers to them, so very large files stay bounded too
+	/// </summary>
+	size_t attributeMemoryBudget = 64 << 20;
+};
+
+/// <summary>
+/// Welded vertices and triangle list indices of part of a mesh, small enough to be its own submesh
+/// </summary>
+struct MeshBatch {
+	std::vector<Vertex> vertices;
+	std::vector<uint16_t> indices;
+};
+
+/// <summary>
+/// Reads an OBJ file in fixed size chunks, welding vertices in windows and emitting them as batches as it goes.
+/// Only positions and texture coordinates are kept for the whole file as faces can refer back to any of them, in memory up to
+/// attributeMemoryBudget and spilled beyond it. Vertices are welded by their attribute indices so vertices are never duplicated within a batch
+/// </summary>
+class ObjStreamReader {
+public:
+	ObjStreamReader(const std::string& path, const ObjStreamConfig& config = ObjStreamConfig());
+
+	/// <summary>
+	/// Reads until the next batch is full or the file ends
+	/// </summary>
+	/// <param name="batch">Cleared then filled with the next batch</param>
+	/// <returns>False once the file has no more faces</returns>
+	bool nextBatch(MeshBatch& batch);
+
+	/// <summary>
+	/// ContentHash of the bytes read so far, the whole file's once nextBatch has returned false
+	/// </summary>
+	const uint64_t getContentHash() const { return contentHash; }
+	const uint64_t getBytesRead() const { return bytesRead; }
+
+private:
+	/// <summary>
+	/// Gets the next line from the file, reading another chunk when needed
+	/// </summary>
+	bool readLine(std::string_view& line);
+
+	/// <summary>
+	/// Adds a face to the batch as a triangle fan
+	/// </summary>
+	/// <returns>False if its vertices don't fit in the batch's window, leaving the batch unchanged</returns>
+	bool addFace(std::string_view face, MeshBatch& batch);
+
+	void parsePosition(std::string_view values);
+	void parseTexCoord(std::string_view values);
+
+private:
+	/// <summary>
+	/// Append only array of one attribute in fixed size pages. At most a budget of pages is held in memory,
+	/// the least recently used ones are written to a temporary file and read back when they are used again
+	/// </summary>
+	template<typename T>
+	class AttributeStore {
+	public:
+		AttributeStore(size_t memoryBudget);
+		~AttributeStore();
+
+		AttributeStore(const AttributeStore&) = delete;
+		AttributeStore& operator=(const AttributeStore&) = delete;
+
+		void push_back(const T& value);
+
+		/// <summary>
+		/// The value at the index, reading its page back from the temporary file if it was spilled
+		/// </summary>
+		const T get(size_t index);
+
+		const size_t size() const { return count; }
+
+	private:
+		struct Page {
+			/// <summary>
+			/// Empty while the page is only in the temporary file
+			/// </summary>
+			std::vector<T> values;
+			uint64_t lastUsed = 0;
+			bool spilled = false;
+		};
+
+		/// <summary>
+		/// Removes the least recently used full page from memory, writing it to the temporary file the first time
+		/// </summary>
+		void evictPage();
+
+	private:
+		static constexpr size_t PAGE_BYTES = 64 * 1024;
+		static constexpr size_t PAGE_VALUES = PAGE_BYTES / sizeof(T);
+
+		const size_t maxResidentPages;
+		std::vector<Page> pages;
+		size_t residentPages = 0;
+		size_t count = 0;
+		uint64_t useCount = 0;
+
+		/// <summary>
+		/// Created with the first spilled page and deleted when closed
+		/// </summary>
+		std::FILE* spillFile = nullptr;
+	};
+
+private:
+	std::ifstream file;
+	const ObjStreamConfig config;
+
+	std::vector<char> chunk;
+	size_t chunkStart = 0;
+	size_t chunkEnd = 0;
+
+	uint64_t contentHash = ContentHash::SEED;
+	uint64_t bytesRead = 0;
+
+	/// <summary>
+	/// Line that spans two chunks, copied together so it can be returned whole
+	/// </summary>
+	std::string spanningLine;
+
+	/// <summary>
+	/// Face that didn't fit in the previous batch, added first to the next one
+	/// </summary>
+	std::string pendingFace;
+
+	AttributeStore<glm::vec3> positions;
+	AttributeStore<glm::vec2> texCoords;
+
+	/// <summary>
+	/// (position index, texture coordinate index) to the vertex's index in the current batch
+	/// </summary>
+	std::unordered_map<uint64_t, uint16_t> weldedVertices;
+	std::vector<uint64_t> faceCorners;
+};
@@ -3,6 +3,8 @@
 #include "Surface.h"
 #include "GraphicsInstance.h"
 
+#include <cstring>
+
 const std::vector<const char*> PhysicalDevice::deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
@@ -32,6 +34,9 @@ PhysicalDevice::PhysicalDevice(const std::unique_ptr<GraphicsInstance>& instance
         // if device unsuitable reset to null otherwise get sample count then finish
         if (checkDeviceSuitable()) {
             msaaSampleCount = getMaxUsableSampleCount();
+            queryDynamicStateSupport();
+            queryDynamicRenderingSupport();
+            queryMultiDrawIndirectSupport();
             break;
         } else {
             this->device = VK_NULL_HANDLE;
@@ -137,4 +142,97 @@ VkSampleCountFlagBits PhysicalDevice::getMaxUsableSampleCount() const {
     if (counts & VK_SAMPLE_COUNT_2_BIT) { return VK_SAMPLE_COUNT_2_BIT; }
 
     return VK_SAMPLE_COUNT_1_BIT;
+}
+
+const std::vector<const char*> PhysicalDevice::getEnabledExtensions() const {
+    std::vector<const char*> extensions = deviceExtensions;
+    if (dynamicStateSupport.extendedDynamicState) extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+    if (dynamicStateSupport.extendedDynamicState2) extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+    if (dynamicStateSupport.polygonMode || dynamicStateSupport.colorBlendEnable || dynamicStateSupport.colorBlendEquation) {
+        extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+    }
+    if (dynamicRenderingSupport) {
+        extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+    }
+    return extensions;
+}
+
+void PhysicalDevice::queryDynamicStateSupport() {
+    dynamicStateSupport = DynamicStateSupport();
+
+    // chain only the feature structs of extensions the device has
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicState{};
+    extendedDynamicState.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extendedDynamicState2{};
+    extendedDynamicState2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3{};
+    extendedDynamicState3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    void** next = &features.pNext;
+    if (hasExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+        *next = &extendedDynamicState;
+        next = &extendedDynamicState.pNext;
+    }
+    if (hasExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+        *next = &extendedDynamicState2;
+        next = &extendedDynamicState2.pNext;
+    }
+    if (hasExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+        *next = &extendedDynamicState3;
+        next = &extendedDynamicState3.pNext;
+    }
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    dynamicStateSupport.extendedDynamicState = extendedDynamicState.extendedDynamicState;
+    dynamicStateSupport.extendedDynamicState2 = extendedDynamicState2.extendedDynamicState2;
+    dynamicStateSupport.polygonMode = extendedDynamicState3.extendedDynamicState3PolygonMode;
+    dynamicStateSupport.colorBlendEnable = extendedDynamicState3.extendedDynamicState3ColorBlendEnable;
+    dynamicStateSupport.colorBlendEquation = extendedDynamicState3.extendedDynamicState3ColorBlendEquation;
+}
+
+void PhysicalDevice::queryDynamicRenderingSupport() {
+    dynamicRenderingSupport = false;
+
+    // dynamic rendering depends on these before Vulkan 1.2
+    if (!hasExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) || !hasExtension(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME) ||
+        !hasExtension(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME)) {
+        return;
+    }
+
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRendering{};
+    dynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &dynamicRendering;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    dynamicRenderingSupport = dynamicRendering.dynamicRendering;
+}
+
+void PhysicalDevice::queryMultiDrawIndirectSupport() {
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(device, &features);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+
+    maxDrawIndirectCount = features.multiDrawIndirect ? properties.limits.maxDrawIndirectCount : 1;
+}
+
+bool PhysicalDevice::hasExtension(const char* extensionName) const {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto& extension : availableExtensions) {
+        if (std::strcmp(extension.extensionName, extensionName) == 0) return true;
+    }
+    return false;
 }
\ No newline at end of file
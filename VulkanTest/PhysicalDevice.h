@@ -23,6 +23,17 @@ struct QueueFamilyIndices {
     }
 };
 
+/// <summary>
+/// Which pipeline states the device can set while recording rather than baking into pipelines, see DynamicState
+/// </summary>
+struct DynamicStateSupport {
+    bool extendedDynamicState = false;  // cull mode, front face, topology and depth test, write and compare op
+    bool extendedDynamicState2 = false; // primitive restart
+    bool polygonMode = false;           // from extended dynamic state 3, as are the rest
+    bool colorBlendEnable = false;
+    bool colorBlendEquation = false;
+};
+
 struct SwapchainSupportDetails {
     VkSurfaceCapabilitiesKHR capabilities;
     std::vector<VkSurfaceFormatKHR> formats;
@@ -37,10 +48,26 @@ public:
     const QueueFamilyIndices getQueueFamilyIndices() const { return queueFamilyIndices; }
     const SwapchainSupportDetails getSwapchainSupportDetails() const { return supportDetails; }
     const VkSampleCountFlagBits getSampleCount() const { return msaaSampleCount; }
+    const DynamicStateSupport getDynamicStateSupport() const { return dynamicStateSupport; }
+
+    /// <summary>
+    /// Whether attachments can be given when rendering begins rather than through a render pass and framebuffers
+    /// </summary>
+    const bool getDynamicRenderingSupport() const { return dynamicRenderingSupport; }
+
+    /// <summary>
+    /// Draw commands one indirect draw can read, 1 without the multiDrawIndirect feature
+    /// </summary>
+    const uint32_t getMaxDrawIndirectCount() const { return maxDrawIndirectCount; }
 
     void updateSwapchainSupport(const std::unique_ptr<Surface>& surface);
 
     static const std::vector<const char*> getDeviceExtensions() { return deviceExtensions; }
+
+    /// <summary>
+    /// The required extensions and the optional ones the device supports
+    /// </summary>
+    const std::vector<const char*> getEnabledExtensions() const;
 private:
     /// <summary>
     /// Checks various suitability requirements of the GPU
@@ -63,6 +90,23 @@ private:
     bool checkDeviceExtensionSupport(VkPhysicalDevice device) const;
 
     VkSampleCountFlagBits getMaxUsableSampleCount() const;
+
+    /// <summary>
+    /// Checks for the extended dynamic state extensions and which of their features the device has
+    /// </summary>
+    void queryDynamicStateSupport();
+
+    /// <summary>
+    /// Checks for VK_KHR_dynamic_rendering and the extensions it depends on
+    /// </summary>
+    void queryDynamicRenderingSupport();
+
+    /// <summary>
+    /// Checks for multiDrawIndirect and how many commands a draw can read with it
+    /// </summary>
+    void queryMultiDrawIndirectSupport();
+
+    bool hasExtension(const char* extensionName) const;
 private:
 	/// <summary>
 	/// Handle to reference the graphics card used by vulkan
@@ -71,6 +115,9 @@ private:
     VkSampleCountFlagBits msaaSampleCount;
     QueueFamilyIndices queueFamilyIndices;
     SwapchainSupportDetails supportDetails;
+    DynamicStateSupport dynamicStateSupport;
+    bool dynamicRenderingSupport;
+    uint32_t maxDrawIndirectCount;
 
     static const std::vector<const char*> deviceExtensions;
 };
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "PipelineCache.h"
+
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+#include "ContentHash.h"
+#include "Debug.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+PipelineCache::PipelineCache(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::string& path) :
+    path(path),
+    device(device) {
+    vkGetPhysicalDeviceProperties(physicalDevice->getPhysicalDevice(), &deviceProperties);
+
+    std::vector<char> data;
+    if (load(data)) {
+        loadedHash = ContentHash::hash(data.data(), data.size());
+    } else {
+        data.clear();
+        Debug::log("no usable pipeline cache, pipelines will be compiled from scratch");
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.data();
+
+    if (vkCreatePipelineCache(device->getDevice(), &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+        Debug::exception("failed to create pipeline cache");
+    }
+}
+
+PipelineCache::~PipelineCache() {
+    vkDestroyPipelineCache(device->getDevice(), pipelineCache, nullptr);
+}
+
+void PipelineCache::save() const {
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device->getDevice(), pipelineCache, &dataSize, nullptr) != VK_SUCCESS) return;
+
+    std::vector<char> data(dataSize);
+    if (vkGetPipelineCacheData(device->getDevice(), pipelineCache, &dataSize, data.data()) != VK_SUCCESS) return;
+    data.resize(dataSize);
+
+    FileHeader header = createHeader();
+    header.dataSize = dataSize;
+    header.dataHash = ContentHash::hash(data.data(), data.size());
+    if (header.dataHash == loadedHash) return;
+
+    // written to a temporary file first so a crash part way through never leaves a partial cache
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open() ||
+            !file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+            !file.write(data.data(), data.size())) {
+            Debug::log("failed to write pipeline cache");
+            return;
+        }
+    }
+
+    std::error_code renameError;
+    std::filesystem::rename(tempPath, path, renameError);
+    if (renameError) {
+        Debug::log("failed to write pipeline cache");
+    }
+}
+
+bool PipelineCache::load(std::vector<char>& data) const {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    const std::streamoff fileSize = file.tellg();
+    file.seekg(0);
+
+    FileHeader header;
+    if (fileSize < static_cast<std::streamoff>(sizeof(header)) || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+
+    // the UUID changes whenever the driver's cache format could, the driver version is checked too as not every driver updates it
+    const FileHeader expected = createHeader();
+    if (header.magic != expected.magic || header.version != expected.version ||
+        header.vendorID != expected.vendorID || header.deviceID != expected.deviceID || header.driverVersion != expected.driverVersion ||
+        std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        return false;
+    }
+
+    // a truncated or corrupt file could claim any size, so it must be exactly what follows the header before anything is allocated
+    if (header.dataSize != static_cast<uint64_t>(fileSize) - sizeof(header)) return false;
+
+    data.resize(static_cast<size_t>(header.dataSize));
+    if (!file.read(data.data(), data.size())) return false;
+    if (ContentHash::hash(data.data(), data.size()) != header.dataHash) return false;
+
+    // the driver's own header should agree, see VkPipelineCacheHeaderVersionOne
+    VkPipelineCacheHeaderVersionOne driverHeader;
+    if (data.size() < sizeof(driverHeader)) return false;
+    std::memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+
+    return driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        driverHeader.vendorID == deviceProperties.vendorID && driverHeader.deviceID == deviceProperties.deviceID &&
+        std::memcmp(driverHeader.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+PipelineCache::FileHeader PipelineCache::createHeader() const {
+    FileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vendorID = deviceProperties.vendorID;
+    header.deviceID = deviceProperties.deviceID;
+    header.driverVersion = deviceProperties.driverVersion;
+    std::memcpy(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+}
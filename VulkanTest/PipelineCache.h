@@ -0,0 +1,69 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+class LogicalDevice;
+class PhysicalDevice;
+
+/// <summary>
+/// Pipeline cache kept on disk between runs so pipelines are only compiled the first time, shared by every pipeline including ImGui's.
+/// The file is only used if it was saved on the same device with the same driver, as drivers may not reject another's data safely
+/// </summary>
+class PipelineCache {
+public:
+	/// <param name="path">File to load the cache from and save it to, an empty cache is used if it is missing or doesn't match</param>
+	PipelineCache(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::string& path);
+	~PipelineCache();
+
+	const VkPipelineCache getPipelineCache() const { return pipelineCache; }
+
+	/// <summary>
+	/// Writes the cache to its file if pipelines were added since it was loaded
+	/// </summary>
+	void save() const;
+
+private:
+	/// <summary>
+	/// Header written before the cache data, identifying the device and driver that saved it
+	/// </summary>
+	struct FileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+
+		/// <summary>
+		/// Hash of the data so a truncated or corrupt file is never handed to the driver
+		/// </summary>
+		uint64_t dataHash;
+	};
+
+	static constexpr uint32_t MAGIC = 0x43505456; // "VTPC"
+	static constexpr uint32_t VERSION = 1;
+
+	/// <summary>
+	/// Reads the file's cache data
+	/// </summary>
+	/// <returns>False if the file is missing, corrupt or from another device or driver</returns>
+	bool load(std::vector<char>& data) const;
+
+	FileHeader createHeader() const;
+
+private:
+	VkPipelineCache pipelineCache;
+
+	VkPhysicalDeviceProperties deviceProperties;
+	const std::string path;
+
+	/// <summary>
+	/// Hash of the data loaded, so saving an unchanged cache can be skipped
+	/// </summary>
+	uint64_t loadedHash = 0;
+
+	const std::unique_ptr<LogicalDevice>& device;
+};
@@ -0,0 +1,182 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "ContentHash.h"
+#include "SpecializationConstants.h"
+#include "VertexLayout.h"
+#include "Debug.h"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/// <summary>
+/// Shader and fixed function state of a graphics pipeline, everything but what it renders to, see PipelineKey.
+/// A literal type so static pipelines are described, hashed and turned into create info at compile time, and plain
+/// values so they're cheap to copy and keep in tables. Defaults match the app's original pipeline
+/// </summary>
+struct PipelineDescription {
+	static constexpr uint32_t MAX_VERTEX_BINDINGS = 4;
+	static constexpr uint32_t MAX_VERTEX_ATTRIBUTES = 16;
+
+	/// <summary>
+	/// Paths of the compiled shaders, as embedded by the AssetCooker, see EmbeddedShaders.
+	/// Only viewed so they must outlive the description, as string literals do
+	/// </summary>
+	std::string_view vertexShader;
+	std::string_view fragmentShader;
+
+	/// <summary>
+	/// Each stage's specialization constants, so variants of a material are separate pipelines of the same shaders
+	/// </summary>
+	SpecializationConstants vertexConstants;
+	SpecializationConstants fragmentConstants;
+
+	/// <summary>
+	/// The first vertexBindingCount and vertexAttributeCount are used, added with addVertexLayout
+	/// </summary>
+	std::array<VkVertexInputBindingDescription, MAX_VERTEX_BINDINGS> vertexBindings{};
+	std::array<VkVertexInputAttributeDescription, MAX_VERTEX_ATTRIBUTES> vertexAttributes{};
+	uint32_t vertexBindingCount = 0;
+	uint32_t vertexAttributeCount = 0;
+
+	/// <summary>
+	/// Each binding's VertexLayout::HASH combined, hashed in place of the descriptions
+	/// </summary>
+	uint64_t vertexLayoutHash = ContentHash::SEED;
+
+	VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	bool primitiveRestartEnable = false;
+
+	VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	bool blendEnable = false;
+	VkBlendFactor srcBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	VkBlendFactor dstBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	bool depthTestEnable = true;
+	bool depthWriteEnable = true;
+	VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+
+	constexpr PipelineDescription& setShaders(std::string_view vertex, std::string_view fragment) {
+		vertexShader = vertex;
+		fragmentShader = fragment;
+		return *this;
+	}
+
+	/// <summary>
+	/// Adds a binding read with T's VertexLayout, its attributes take the locations after those already added
+	/// </summary>
+	template<typename T>
+	constexpr PipelineDescription& addVertexLayout(uint32_t binding, VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX) {
+		if (vertexBindingCount == MAX_VERTEX_BINDINGS || vertexAttributeCount + VertexLayout<T>::LOCATION_COUNT > MAX_VERTEX_ATTRIBUTES) {
+			Debug::exception("too many vertex bindings or attributes for a pipeline description");
+		}
+
+		vertexBindings[vertexBindingCount++] = VertexLayout<T>::getBindingDescription(binding, inputRate);
+		for (const VkVertexInputAttributeDescription& attribute : VertexLayout<T>::getAttributeDescriptions(binding, vertexAttributeCount)) {
+			vertexAttributes[vertexAttributeCount++] = attribute;
+		}
+
+		vertexLayoutHash = ContentHash::hashValue(VertexLayout<T>::HASH, vertexLayoutHash);
+		vertexLayoutHash = ContentHash::hashValue(binding, vertexLayoutHash);
+		vertexLayoutHash = ContentHash::hashValue(static_cast<uint32_t>(inputRate), vertexLayoutHash);
+		return *this;
+	}
+
+	constexpr bool operator==(const PipelineDescription& other) const {
+		if (vertexBindingCount != other.vertexBindingCount || vertexAttributeCount != other.vertexAttributeCount) return false;
+		for (uint32_t i = 0; i < vertexBindingCount; i++) {
+			const VkVertexInputBindingDescription& a = vertexBindings[i];
+			const VkVertexInputBindingDescription& b = other.vertexBindings[i];
+			if (a.binding != b.binding || a.stride != b.stride || a.inputRate != b.inputRate) return false;
+		}
+		for (uint32_t i = 0; i < vertexAttributeCount; i++) {
+			const VkVertexInputAttributeDescription& a = vertexAttributes[i];
+			const VkVertexInputAttributeDescription& b = other.vertexAttributes[i];
+			if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset) return false;
+		}
+
+		return vertexShader == other.vertexShader && fragmentShader == other.fragmentShader &&
+			vertexConstants == other.vertexConstants && fragmentConstants == other.fragmentConstants &&
+			vertexLayoutHash == other.vertexLayoutHash &&
+			topology == other.topology && primitiveRestartEnable == other.primitiveRestartEnable &&
+			polygonMode == other.polygonMode && cullMode == other.cullMode && frontFace == other.frontFace &&
+			blendEnable == other.blendEnable && srcBlendFactor == other.srcBlendFactor && dstBlendFactor == other.dstBlendFactor &&
+			depthTestEnable == other.depthTestEnable && depthWriteEnable == other.depthWriteEnable && depthCompareOp == other.depthCompareOp;
+	}
+
+	/// <summary>
+	/// Hash of every field, the vertex input by its layout hash, so static descriptions hash at compile time
+	/// </summary>
+	constexpr uint64_t hash(uint64_t hash = ContentHash::SEED) const {
+		hash = ContentHash::hashString(vertexShader, hash);
+		hash = ContentHash::hashString(fragmentShader, hash);
+		hash = vertexConstants.hash(hash);
+		hash = fragmentConstants.hash(hash);
+
+		hash = ContentHash::hashValue(vertexLayoutHash, hash);
+		hash = ContentHash::hashValue(static_cast<uint32_t>(topology), hash);
+		hash = ContentHash::hashValue(static_cast<uint32_t>(primitiveRestartEnable), hash);
+
+		hash = ContentHash::hashValue(static_cast<uint32_t>(polygonMode), hash);
+		hash = ContentHash::hashValue(static_cast<uint32_t>(cullMode), hash);
+		hash = ContentHash::hashValue(static_cast<uint32_t>(frontFace), hash);
+
+		hash = ContentHash::hashValue(static_cast<uint32_t>(blendEnable), hash);
+		hash = ContentHash::hashValue(static_cast<uint32_t>(srcBlendFactor), hash);
+		hash = ContentHash::hashValue(static_cast<uint32_t>(dstBlendFactor), hash);
+
+		hash = ContentHash::hashValue(static_cast<uint32_t>(depthTestEnable), hash);
+		hash = ContentHash::hashValue(static_cast<uint32_t>(depthWriteEnable), hash);
+		return ContentHash::hashValue(static_cast<uint32_t>(depthCompareOp), hash);
+	}
+
+	// create info for the fixed function stages, the parts not pointing at anything so they can be made at compile time
+
+	constexpr VkPipelineInputAssemblyStateCreateInfo getInputAssemblyState() const {
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = topology;
+		inputAssembly.primitiveRestartEnable = primitiveRestartEnable ? VK_TRUE : VK_FALSE;
+		return inputAssembly;
+	}
+
+	constexpr VkPipelineRasterizationStateCreateInfo getRasterizationState() const {
+		VkPipelineRasterizationStateCreateInfo rasterizer{};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.depthClampEnable = VK_FALSE;
+		rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		rasterizer.polygonMode = polygonMode;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = cullMode;
+		rasterizer.frontFace = frontFace;
+		rasterizer.depthBiasEnable = VK_FALSE;
+		return rasterizer;
+	}
+
+	constexpr VkPipelineColorBlendAttachmentState getColorBlendAttachment() const {
+		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = blendEnable ? VK_TRUE : VK_FALSE;
+		colorBlendAttachment.srcColorBlendFactor = srcBlendFactor;
+		colorBlendAttachment.dstColorBlendFactor = dstBlendFactor;
+		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		return colorBlendAttachment;
+	}
+
+	constexpr VkPipelineDepthStencilStateCreateInfo getDepthStencilState() const {
+		VkPipelineDepthStencilStateCreateInfo depthStencil{};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = depthTestEnable ? VK_TRUE : VK_FALSE;
+		depthStencil.depthWriteEnable = depthWriteEnable ? VK_TRUE : VK_FALSE;
+		depthStencil.depthCompareOp = depthCompareOp;
+		depthStencil.depthBoundsTestEnable = VK_FALSE; // Limit the depth range to keep fragments
+		depthStencil.stencilTestEnable = VK_FALSE; // stencil testing with stencil buffer
+		return depthStencil;
+	}
+};
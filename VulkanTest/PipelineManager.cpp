@@ -0,0 +1,319 @@
+#include "PipelineManager.h"
+
+#include "ContentHash.h"
+#include "EmbeddedShaders.h"
+#include "LogicalDevice.h"
+#include "PipelineCache.h"
+#include "DynamicState.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    template<typename T>
+    uint64_t hashValue(uint64_t hash, const T& value) {
+        return ContentHash::hash(&value, sizeof(value), hash);
+    }
+}
+
+void PipelineKey::setDescription(const PipelineDescription& description, uint64_t descriptionHash) {
+    // a stale hash would file the key in the wrong bucket, so check it while validating
+    if (enableValidationLayers && descriptionHash != description.hash()) {
+        Debug::exception("pipeline description hash doesn't match the description");
+    }
+    this->description = description;
+    this->descriptionHash = descriptionHash;
+}
+
+bool PipelineKey::operator==(const PipelineKey& other) const {
+    // differing hashes rule out most keys before comparing every field
+    return descriptionHash == other.descriptionHash && description == other.description && samples == other.samples &&
+        layout == other.layout && renderPass == other.renderPass && subpass == other.subpass &&
+        colorFormat == other.colorFormat && depthFormat == other.depthFormat;
+}
+
+uint64_t PipelineKey::hash() const {
+    // handles only exist at runtime, so they're hashed by their bytes
+    uint64_t hash = descriptionHash;
+    hash = hashValue(hash, samples);
+    hash = hashValue(hash, layout);
+    hash = hashValue(hash, renderPass);
+    hash = hashValue(hash, subpass);
+    hash = hashValue(hash, colorFormat);
+    return hashValue(hash, depthFormat);
+}
+
+PipelineManager::PipelineManager(ThreadPool& threadPool, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PipelineCache>& pipelineCache,
+    const std::unique_ptr<DynamicState>& dynamicState) :
+    threadPool(threadPool),
+    device(device),
+    pipelineCache(pipelineCache),
+    dynamicState(dynamicState) {
+    const char* overrideDirectory = std::getenv(SHADER_OVERRIDE_VARIABLE);
+    if (overrideDirectory) {
+        shaderOverrideDirectory = overrideDirectory;
+        Debug::log("reading shaders from " + shaderOverrideDirectory + " where it has them");
+    }
+}
+
+PipelineManager::~PipelineManager() {
+    // compiles catch their own exceptions, so this only waits
+    threadPool.wait(compileJobs);
+
+    for (const auto& entry : entries) {
+        vkDestroyPipeline(device->getDevice(), entry->pipeline, nullptr);
+    }
+}
+
+uint32_t PipelineManager::create(const PipelineKey& key) {
+    bool created = false;
+    const uint32_t id = findOrAdd(key, NO_FALLBACK, created);
+    if (!created) {
+        // an earlier request may share the pipeline while it still compiles on the pool, so help the pool until it's done.
+        // Compiles aren't counted one by one so this waits for all of them, which only happens before the first frame
+        if (entries[requests[id].entry]->state.load(std::memory_order_acquire) == PipelineState::Compiling) {
+            threadPool.wait(compileJobs);
+        }
+        if (findReady(id) == NO_FALLBACK) {
+            Debug::exception("pipeline shared with an earlier request failed to compile");
+        }
+        return id;
+    }
+
+    // nothing to fall back to, so a failure here is fatal
+    PipelineEntry& entry = *entries[requests[id].entry];
+    entry.pipeline = compile(key);
+    entry.state.store(PipelineState::Ready, std::memory_order_release);
+    return id;
+}
+
+uint32_t PipelineManager::request(const PipelineKey& key, uint32_t fallback) {
+    bool created = false;
+    const uint32_t id = findOrAdd(key, fallback, created);
+    if (!created) return id;
+
+    PipelineEntry* entry = entries[requests[id].entry].get();
+    threadPool.run([this, entry]() {
+        try {
+            entry->pipeline = compile(entry->key);
+            entry->state.store(PipelineState::Ready, std::memory_order_release);
+        }
+        catch (const std::exception& e) {
+            Debug::log(std::string("pipeline failed to compile, drawing with its fallback: ") + e.what());
+            entry->state.store(PipelineState::Failed, std::memory_order_release);
+        }
+    }, compileJobs);
+
+    return id;
+}
+
+const VkPipeline PipelineManager::getPipeline(uint32_t id) const {
+    const uint32_t ready = findReady(id);
+    if (ready == NO_FALLBACK) return VK_NULL_HANDLE;
+    return entries[requests[ready].entry]->pipeline;
+}
+
+void PipelineManager::bind(VkCommandBuffer commandBuffer, uint32_t id) const {
+    const uint32_t ready = findReady(id);
+    if (ready == NO_FALLBACK) {
+        Debug::exception("no pipeline ready to bind");
+    }
+
+    // a fallback's own dynamic state is set as the pipeline may not support the requested topology
+    const PipelineRequest& request = requests[ready];
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, entries[request.entry]->pipeline);
+    dynamicState->record(commandBuffer, request.key);
+}
+
+uint32_t PipelineManager::findOrAdd(const PipelineKey& key, uint32_t fallback, bool& created) {
+    auto existing = keyRequests.find(key);
+    if (existing != keyRequests.end()) return existing->second;
+
+    const uint32_t id = static_cast<uint32_t>(requests.size());
+    requests.push_back({ key, 0, fallback });
+    keyRequests[key] = id;
+
+    // keys only differing in dynamic state share the pipeline, so it may already be compiled
+    PipelineKey entryKey = key;
+    dynamicState->removeDynamicState(entryKey);
+
+    auto existingEntry = keyEntries.find(entryKey);
+    if (existingEntry != keyEntries.end()) {
+        requests.back().entry = existingEntry->second;
+        return id;
+    }
+
+    const uint32_t entry = static_cast<uint32_t>(entries.size());
+    entries.push_back(std::make_unique<PipelineEntry>());
+    entries.back()->key = entryKey;
+    keyEntries[entryKey] = entry;
+    requests.back().entry = entry;
+
+    created = true;
+    return id;
+}
+
+uint32_t PipelineManager::findReady(uint32_t id) const {
+    // fallbacks can have fallbacks of their own
+    while (id != NO_FALLBACK) {
+        const PipelineRequest& request = requests[id];
+        if (entries[request.entry]->state.load(std::memory_order_acquire) == PipelineState::Ready) return id;
+        id = request.fallback;
+    }
+    return NO_FALLBACK;
+}
+
+VkPipeline PipelineManager::compile(const PipelineKey& key) const {
+    const PipelineDescription& description = key.description;
+
+    VkShaderModule vertShaderModule = createShaderModule(description.vertexShader);
+    VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+    try {
+        fragShaderModule = createShaderModule(description.fragmentShader);
+    }
+    catch (...) {
+        vkDestroyShaderModule(device->getDevice(), vertShaderModule, nullptr);
+        throw;
+    }
+
+    // create info for both shaders, specialised with the description's constants
+    const VkSpecializationInfo vertSpecializationInfo = description.vertexConstants.getInfo();
+    const VkSpecializationInfo fragSpecializationInfo = description.fragmentConstants.getInfo();
+
+    std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
+    shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = vertShaderModule;
+    shaderStages[0].pName = "main";
+    shaderStages[0].pSpecializationInfo = description.vertexConstants.isEmpty() ? nullptr : &vertSpecializationInfo;
+
+    shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = fragShaderModule;
+    shaderStages[1].pName = "main";
+    shaderStages[1].pSpecializationInfo = description.fragmentConstants.isEmpty() ? nullptr : &fragSpecializationInfo;
+
+    // dynamic state, what the device supports setting while recording is ignored below
+    const std::vector<VkDynamicState> dynamicStates = dynamicState->getDynamicStates();
+
+    VkPipelineDynamicStateCreateInfo dynamicStateInfo{};
+    dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicStateInfo.pDynamicStates = dynamicStates.data();
+
+    // vertex input
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = description.vertexBindingCount;
+    vertexInputInfo.vertexAttributeDescriptionCount = description.vertexAttributeCount;
+    vertexInputInfo.pVertexBindingDescriptions = description.vertexBindings.data();
+    vertexInputInfo.pVertexAttributeDescriptions = description.vertexAttributes.data();
+
+    // input type, rasterizer, blending and depth come straight from the description
+    const VkPipelineInputAssemblyStateCreateInfo inputAssembly = description.getInputAssemblyState();
+    const VkPipelineRasterizationStateCreateInfo rasterizer = description.getRasterizationState();
+    const VkPipelineColorBlendAttachmentState colorBlendAttachment = description.getColorBlendAttachment();
+    const VkPipelineDepthStencilStateCreateInfo depthStencil = description.getDepthStencilState();
+
+    // viewport state (0 cause dynamic)
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    // multisampling
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = key.samples;
+
+    // blending
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    // CREATE PIPELINE
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages = shaderStages.data();
+
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicStateInfo;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+
+    pipelineInfo.layout = key.layout;
+    pipelineInfo.renderPass = key.renderPass;
+    pipelineInfo.subpass = key.subpass;
+
+    // without a render pass the attachments' formats are given instead
+    VkPipelineRenderingCreateInfoKHR renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachmentFormats = &key.colorFormat;
+    renderingInfo.depthAttachmentFormat = key.depthFormat;
+    if (key.renderPass == VK_NULL_HANDLE) {
+        pipelineInfo.pNext = &renderingInfo;
+    }
+
+    // the pipeline cache is internally synchronised, so workers can compile into it at once
+    VkPipeline pipeline;
+    const VkResult result = vkCreateGraphicsPipelines(device->getDevice(), pipelineCache->getPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
+
+    // destroy used shaders
+    vkDestroyShaderModule(device->getDevice(), fragShaderModule, nullptr);
+    vkDestroyShaderModule(device->getDevice(), vertShaderModule, nullptr);
+
+    if (result != VK_SUCCESS) {
+        Debug::exception("failed to create graphics pipeline");
+    }
+    return pipeline;
+}
+
+VkShaderModule PipelineManager::createShaderModule(std::string_view path) const {
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+
+    // shaders recompiled since the build are only read when developing with an override directory
+    std::vector<char> overrideCode;
+    const std::filesystem::path overridePath = std::filesystem::path(shaderOverrideDirectory) / path;
+    if (!shaderOverrideDirectory.empty() && std::filesystem::exists(overridePath)) {
+        std::ifstream file(overridePath, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) {
+            Debug::exception("failed to open file");
+        }
+
+        overrideCode.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(overrideCode.data(), overrideCode.size());
+
+        createInfo.codeSize = overrideCode.size();
+        createInfo.pCode = reinterpret_cast<const uint32_t*>(overrideCode.data());
+    } else {
+        const std::span<const uint32_t> code = EmbeddedShaders::find(path);
+        if (code.empty()) {
+            Debug::exception("shader isn't embedded, run the AssetCooker and rebuild");
+        }
+
+        createInfo.codeSize = code.size_bytes();
+        createInfo.pCode = code.data();
+    }
+
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(device->getDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        Debug::exception("failed to create shader module");
+    }
+
+    return shaderModule;
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "ThreadPool.h"
+#include "PipelineDescription.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class LogicalDevice;
+class PipelineCache;
+class DynamicState;
+
+/// <summary>
+/// A pipeline's description along with what it renders to, requests with equal keys share one pipeline.
+/// Viewport and scissor are always dynamic so pipelines don't depend on the swapchain's size, and state the device
+/// can set while recording is too so keys only differing in it also share one, see DynamicState
+/// </summary>
+struct PipelineKey {
+	/// <summary>
+	/// Set with setDescription, or call rehashDescription after changing it in place so descriptionHash stays in step
+	/// </summary>
+	PipelineDescription description;
+
+	/// <summary>
+	/// Hash of the description, kept so lookups don't hash it again. Static descriptions are given the hash they computed at compile time
+	/// </summary>
+	uint64_t descriptionHash = PipelineDescription().hash();
+
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineLayout layout = VK_NULL_HANDLE;
+
+	/// <summary>
+	/// Null for dynamic rendering, which is given the attachments' formats instead
+	/// </summary>
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	uint32_t subpass = 0;
+	VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+	VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+	void setDescription(const PipelineDescription& description, uint64_t descriptionHash);
+	void rehashDescription() { descriptionHash = description.hash(); }
+
+	bool operator==(const PipelineKey& other) const;
+
+	/// <summary>
+	/// The stored description hash continued with the rest, see PipelineDescription::hash
+	/// </summary>
+	uint64_t hash() const;
+};
+
+struct PipelineKeyHash {
+	size_t operator()(const PipelineKey& key) const { return static_cast<size_t>(key.hash()); }
+};
+
+/// <summary>
+/// Builds graphics pipelines from PipelineKeys, compiling each distinct key once on the thread pool.
+/// Until a pipeline has compiled, or if it failed to, its fallback is drawn with instead so the render loop never waits on the driver
+/// </summary>
+class PipelineManager {
+public:
+	PipelineManager(ThreadPool& threadPool, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PipelineCache>& pipelineCache,
+		const std::unique_ptr<DynamicState>& dynamicState);
+
+	/// <summary>
+	/// Waits for compiles in progress then destroys every pipeline
+	/// </summary>
+	~PipelineManager();
+
+	static constexpr uint32_t NO_FALLBACK = ~0u;
+
+	/// <summary>
+	/// Environment variable naming a directory to read compiled shaders from before the embedded ones, such as the project directory
+	/// so shaders compiled since the build are used without rebuilding
+	/// </summary>
+	static constexpr const char* SHADER_OVERRIDE_VARIABLE = "VULKANTEST_SHADER_DIR";
+
+	/// <summary>
+	/// Compiles the pipeline on the calling thread, for pipelines needed before the first frame such as fallbacks.
+	/// If an earlier request shares the pipeline and it's still compiling on the pool, waits for it instead, so the pipeline is always ready to bind
+	/// </summary>
+	/// <returns>Id of the pipeline, the same as any earlier request for an equal key</returns>
+	uint32_t create(const PipelineKey& key);
+
+	/// <summary>
+	/// Starts compiling the pipeline on the pool, returning straight away
+	/// </summary>
+	/// <param name="fallback">Pipeline drawn with until this one is ready, it must share the layout and render pass or attachment formats</param>
+	/// <returns>Id of the pipeline, the same as any earlier request for an equal key</returns>
+	uint32_t request(const PipelineKey& key, uint32_t fallback);
+
+	/// <returns>The pipeline if it has compiled, otherwise its fallback's, or null if neither is ready</returns>
+	const VkPipeline getPipeline(uint32_t id) const;
+
+	/// <summary>
+	/// Binds the pipeline, or its fallback until it's ready, then sets the dynamic state of the key it was requested with
+	/// </summary>
+	void bind(VkCommandBuffer commandBuffer, uint32_t id) const;
+
+	const bool isReady(uint32_t id) const { return entries[requests[id].entry]->state.load(std::memory_order_acquire) == PipelineState::Ready; }
+
+	/// <summary>
+	/// Helps the pool until every compile started so far has finished, such as before saving the pipeline cache
+	/// </summary>
+	void waitForCompiles() { threadPool.wait(compileJobs); }
+
+private:
+	enum class PipelineState {
+		Compiling,
+		Ready,
+		Failed
+	};
+
+	/// <summary>
+	/// A compiled pipeline, its key has the dynamic state removed
+	/// </summary>
+	struct PipelineEntry {
+		PipelineKey key;
+
+		/// <summary>
+		/// Set by the compiling worker once the pipeline is written, only read the pipeline after seeing Ready
+		/// </summary>
+		std::atomic<PipelineState> state = PipelineState::Compiling;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+	};
+
+	/// <summary>
+	/// A requested key, the dynamic state it keeps is set when binding
+	/// </summary>
+	struct PipelineRequest {
+		PipelineKey key;
+		uint32_t entry = 0;
+		uint32_t fallback = NO_FALLBACK;
+	};
+
+	/// <summary>
+	/// Finds the request for an equal key, otherwise adds one along with an entry for its pipeline if no other request shares it
+	/// </summary>
+	/// <param name="created">Set if the entry was added, so it needs compiling</param>
+	uint32_t findOrAdd(const PipelineKey& key, uint32_t fallback, bool& created);
+
+	/// <returns>The request whose pipeline is drawn with for the id, or NO_FALLBACK if none are ready</returns>
+	uint32_t findReady(uint32_t id) const;
+
+	/// <summary>
+	/// Reads the shaders and creates the pipeline, safe to call from any thread
+	/// </summary>
+	VkPipeline compile(const PipelineKey& key) const;
+
+	/// <summary>
+	/// Creates the module straight from the embedded SPIR-V, or from the override directory if it has the shader
+	/// </summary>
+	VkShaderModule createShaderModule(std::string_view path) const;
+
+private:
+	ThreadPool& threadPool;
+	const std::unique_ptr<LogicalDevice>& device;
+	const std::unique_ptr<PipelineCache>& pipelineCache;
+	const std::unique_ptr<DynamicState>& dynamicState;
+
+	/// <summary>
+	/// Empty unless set by SHADER_OVERRIDE_VARIABLE
+	/// </summary>
+	std::string shaderOverrideDirectory;
+
+	/// <summary>
+	/// Requests by id, only used on the main thread
+	/// </summary>
+	std::vector<PipelineRequest> requests;
+	std::unordered_map<PipelineKey, uint32_t, PipelineKeyHash> keyRequests;
+
+	/// <summary>
+	/// Compiled pipelines, only added to on the main thread. Entries are never moved so workers can write to them as the vector grows
+	/// </summary>
+	std::vector<std::unique_ptr<PipelineEntry>> entries;
+	std::unordered_map<PipelineKey, uint32_t, PipelineKeyHash> keyEntries;
+
+	/// <summary>
+	/// Compiles in progress on the pool
+	/// </summary>
+	JobCounter compileJobs;
+};
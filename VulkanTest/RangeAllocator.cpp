@@ -0,0 +1,50 @@
+#include "RangeAllocator.h"
+
+#include "Debug.h"
+
+#include <iterator>
+
+RangeAllocator::RangeAllocator(uint32_t size) :
+    size(size), freeCount(size) {
+    if (size > 0) freeRanges[0] = size;
+}
+
+std::optional<uint32_t> RangeAllocator::allocate(uint32_t count) {
+    if (count == 0) return 0;
+
+    for (auto range = freeRanges.begin(); range != freeRanges.end(); range++) {
+        const auto [offset, rangeCount] = *range;
+        if (rangeCount < count) continue;
+
+        // take the start of the range, leaving the rest free
+        freeRanges.erase(range);
+        if (rangeCount > count) freeRanges[offset + count] = rangeCount - count;
+        freeCount -= count;
+        return offset;
+    }
+
+    return std::nullopt;
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t count) {
+    if (count == 0) return;
+    if (offset + count > size) {
+        Debug::exception("freed range is outside the allocator");
+    }
+    freeCount += count;
+
+    // merge with the free range after then the one before, where they touch
+    auto next = freeRanges.lower_bound(offset);
+    if (next != freeRanges.end() && offset + count == next->first) {
+        count += next->second;
+        next = freeRanges.erase(next);
+    }
+    if (next != freeRanges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += count;
+            return;
+        }
+    }
+    freeRanges[offset] = count;
+}
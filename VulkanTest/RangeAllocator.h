@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <optional>
+
+/// <summary>
+/// Hands out ranges of a fixed size space, such as elements of a shared buffer. First fit, with freed ranges
+/// merged back into their neighbours so the space doesn't fragment into pieces too small to use
+/// </summary>
+class RangeAllocator {
+public:
+	RangeAllocator(uint32_t size);
+
+	/// <returns>Offset of count free elements, or nothing if no free range is large enough</returns>
+	std::optional<uint32_t> allocate(uint32_t count);
+
+	/// <summary>
+	/// Returns a range from allocate to the free space
+	/// </summary>
+	void free(uint32_t offset, uint32_t count);
+
+	const uint32_t getSize() const { return size; }
+	const uint32_t getFreeCount() const { return freeCount; }
+
+private:
+	/// <summary>
+	/// Free ranges' counts by their offset, ordered so neighbours are found when freeing
+	/// </summary>
+	std::map<uint32_t, uint32_t> freeRanges;
+
+	uint32_t size;
+	uint32_t freeCount;
+};
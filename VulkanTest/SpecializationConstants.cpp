@@ -0,0 +1,10 @@
+#include "SpecializationConstants.h"
+
+const VkSpecializationInfo SpecializationConstants::getInfo() const {
+    VkSpecializationInfo info{};
+    info.mapEntryCount = count;
+    info.pMapEntries = entries.data();
+    info.dataSize = count * sizeof(uint32_t);
+    info.pData = data.data();
+    return info;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "ContentHash.h"
+#include "Debug.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+/// <summary>
+/// Values for a shader stage's specialization constants, the layout(constant_id = n) consts in GLSL. They're baked in
+/// when the pipeline compiles so each variant drops the code it doesn't use, rather than branching on a uniform each draw.
+/// Every value is 4 bytes, constants the shader doesn't declare are ignored and the rest keep their defaults from the shader.
+/// Fixed size so descriptions holding them can be built at compile time, see PipelineDescription
+/// </summary>
+class SpecializationConstants {
+public:
+	static constexpr uint32_t MAX_CONSTANTS = 8;
+
+	/// <summary>
+	/// Sets the constant, replacing any value it already has
+	/// </summary>
+	constexpr SpecializationConstants& set(uint32_t constantID, bool value) {
+		// bool constants are 32 bit VkBool32s in SPIR-V
+		return setWord(constantID, value ? VK_TRUE : VK_FALSE);
+	}
+	constexpr SpecializationConstants& set(uint32_t constantID, int32_t value) { return setWord(constantID, static_cast<uint32_t>(value)); }
+	constexpr SpecializationConstants& set(uint32_t constantID, uint32_t value) { return setWord(constantID, value); }
+	constexpr SpecializationConstants& set(uint32_t constantID, float value) { return setWord(constantID, std::bit_cast<uint32_t>(value)); }
+
+	constexpr bool isEmpty() const { return count == 0; }
+
+	/// <summary>
+	/// Info pointing into this, so only valid until it is changed or destroyed
+	/// </summary>
+	const VkSpecializationInfo getInfo() const;
+
+	constexpr bool operator==(const SpecializationConstants& other) const {
+		// entries are sorted and each value's offset follows from its position, so comparing ids and values is enough
+		if (count != other.count) return false;
+		for (uint32_t i = 0; i < count; i++) {
+			if (entries[i].constantID != other.entries[i].constantID || data[i] != other.data[i]) return false;
+		}
+		return true;
+	}
+
+	/// <param name="hash">Hash of the data before this, see ContentHash</param>
+	constexpr uint64_t hash(uint64_t hash) const {
+		hash = ContentHash::hashValue(count, hash);
+		for (uint32_t i = 0; i < count; i++) {
+			hash = ContentHash::hashValue(entries[i].constantID, hash);
+			hash = ContentHash::hashValue(data[i], hash);
+		}
+		return hash;
+	}
+
+private:
+	constexpr SpecializationConstants& setWord(uint32_t constantID, uint32_t word) {
+		uint32_t index = 0;
+		while (index < count && entries[index].constantID < constantID) index++;
+		if (index < count && entries[index].constantID == constantID) {
+			data[index] = word;
+			return *this;
+		}
+
+		if (count == MAX_CONSTANTS) {
+			Debug::exception("too many specialization constants, raise MAX_CONSTANTS");
+		}
+
+		// move the later values along to keep them sorted
+		for (uint32_t i = count; i > index; i--) {
+			entries[i] = entries[i - 1];
+			data[i] = data[i - 1];
+		}
+		entries[index] = { constantID, 0, sizeof(uint32_t) };
+		data[index] = word;
+		count++;
+
+		for (uint32_t i = index; i < count; i++) {
+			entries[i].offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+		}
+		return *this;
+	}
+
+private:
+	/// <summary>
+	/// The first count are used, sorted by constant id so equal sets of constants compare and hash equal whatever order they were set in
+	/// </summary>
+	std::array<VkSpecializationMapEntry, MAX_CONSTANTS> entries{};
+
+	/// <summary>
+	/// Each constant's value, at the offset given by its entry
+	/// </summary>
+	std::array<uint32_t, MAX_CONSTANTS> data{};
+	uint32_t count = 0;
+};
@@ -11,8 +11,29 @@
 const std::string MODEL_PATH = "models/viking_room.obj";
 const std::string TEXTURE_PATH = "textures/viking_room.png";
 
+// cooked assets packed into one archive by the AssetCooker so a cold start reads a single mapped file, see AssetPack
+const std::string PACK_PATH = "assets.pack";
+
+// driver compiled pipelines from previous runs, see PipelineCache
+const std::string PIPELINE_CACHE_PATH = "pipeline.cache";
+
 constexpr int MAX_FRAMES_IN_FLIGHT = 3;
 
+// copies of the model the instancing slider goes up to, see InstanceBuffer
+constexpr int MAX_INSTANCES = 16384;
+
+// vertices and 16 bit indices the shared geometry buffer holds for every model, see GeometryBuffer
+constexpr uint32_t GEOMETRY_VERTEX_CAPACITY = 1 << 20;
+constexpr uint32_t GEOMETRY_INDEX_CAPACITY = 1 << 22;
+
+// constant_ids of the specialization constants in shader.frag, see SpecializationConstants
+enum FragmentConstant : uint32_t {
+    FRAGMENT_USE_TEXTURE = 0,
+    FRAGMENT_USE_VERTEX_COLOR = 1,
+    FRAGMENT_ALPHA_TEST = 2,
+    FRAGMENT_ALPHA_CUTOFF = 3
+};
+
 struct UniformBufferObject {
     glm::mat4 model;
     glm::mat4 view;
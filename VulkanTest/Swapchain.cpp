@@ -38,7 +38,11 @@ void Swapchain::createRenderResources(const std::unique_ptr<PhysicalDevice>& phy
                                       const std::unique_ptr<CommandPool>& transferPool, const std::unique_ptr<CommandPool>& graphicsPool) {
     createDepthResources(physicalDevice, transferPool, graphicsPool);
     createColorResources(physicalDevice);
-    createFramebuffers(renderPass);
+
+    // dynamic rendering is given the attachments when it begins instead
+    if (renderPass != VK_NULL_HANDLE) {
+        createFramebuffers(renderPass);
+    }
 }
 
 const float Swapchain::getAspectRatio() const {
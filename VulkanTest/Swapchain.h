@@ -15,6 +15,9 @@ public:
     Swapchain(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<Surface>& surface, VkExtent2D surfaceExtent, const Swapchain* oldSwapchain = nullptr);
     ~Swapchain();
 
+    /// <summary>
+    /// Creates the depth and multisampled colour attachments, and the framebuffers unless the render pass is null for dynamic rendering
+    /// </summary>
     void createRenderResources(const std::unique_ptr<PhysicalDevice>& physicalDevice, const VkRenderPass renderPass, 
                                const std::unique_ptr<CommandPool>& transferPool, const std::unique_ptr<CommandPool>& graphicsPool);
 
@@ -24,6 +27,14 @@ public:
     const VkFormat getDepthFormat() const { return depthFormat; }
     const VkExtent2D getExtent() const { return imageExtent; }
     const VkFramebuffer getFrameBuffer(uint32_t index) { return framebuffers[index]; }
+
+    // attachments, for dynamic rendering
+    const VkImage getImage(uint32_t index) const { return images[index]; }
+    const VkImageView getImageView(uint32_t index) const { return imageViews[index]; }
+    const VkImage getColorImage() const { return colorImage; }
+    const VkImageView getColorImageView() const { return colorImageView; }
+    const VkImage getDepthImage() const { return depthImage; }
+    const VkImageView getDepthImageView() const { return depthImageView; }
 private:
     void createHandle(const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<Surface>& surface, VkExtent2D surfaceExtent, const Swapchain* oldSwapchain);
     void createImageViews();
@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template<typename T>
+class Task;
+
+namespace TaskPromise {
+	/// <summary>
+	/// State shared by every task's promise, the coroutine waiting on the task and how it finished
+	/// </summary>
+	struct PromiseBase {
+		std::coroutine_handle<> continuation;
+		std::exception_ptr exception;
+
+		/// <summary>
+		/// Only set for tasks without a continuation, as those are polled from another thread
+		/// </summary>
+		std::atomic<bool> finished = false;
+
+		/// <summary>
+		/// Resumes the awaiting coroutine on whichever thread the task finished on
+		/// </summary>
+		struct FinalAwaiter {
+			bool await_ready() const noexcept { return false; }
+
+			template<typename Promise>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+				PromiseBase& promise = handle.promise();
+				if (promise.continuation) return promise.continuation;
+
+				promise.finished.store(true, std::memory_order_release);
+				return std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		// tasks are lazy, nothing runs until awaited or started
+		std::suspend_always initial_suspend() const noexcept { return {}; }
+		FinalAwaiter final_suspend() const noexcept { return {}; }
+		void unhandled_exception() { exception = std::current_exception(); }
+
+		void rethrow() const {
+			if (exception) std::rethrow_exception(exception);
+		}
+	};
+
+	template<typename T>
+	struct Promise : PromiseBase {
+		std::optional<T> value;
+
+		Task<T> get_return_object();
+		void return_value(T result) { value = std::move(result); }
+
+		T result() {
+			rethrow();
+			return std::move(*value);
+		}
+	};
+
+	template<>
+	struct Promise<void> : PromiseBase {
+		Task<void> get_return_object();
+		void return_void() {}
+
+		void result() { rethrow(); }
+	};
+}
+
+/// <summary>
+/// Lazily started coroutine returning a T. Awaiting a task runs it and resumes the awaiting coroutine
+/// once it finishes, on whichever thread it finished on, rethrowing anything it threw.
+/// Where the task runs is up to what it awaits, such as ThreadPool::schedule to move onto a worker
+/// </summary>
+template<typename T = void>
+class Task {
+public:
+	using promise_type = TaskPromise::Promise<T>;
+
+	Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+	Task& operator=(Task&& other) noexcept {
+		if (this != &other) {
+			if (handle) handle.destroy();
+			handle = std::exchange(other.handle, nullptr);
+		}
+		return *this;
+	}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task() {
+		if (handle) handle.destroy();
+	}
+
+	bool await_ready() const noexcept { return false; }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+		handle.promise().continuation = awaiting;
+		return handle;
+	}
+	T await_resume() { return handle.promise().result(); }
+
+	/// <summary>
+	/// Runs the task without awaiting it, poll isDone then call get for the result
+	/// </summary>
+	void start() { handle.resume(); }
+
+	/// <summary>
+	/// Only valid for tasks that were started rather than awaited
+	/// </summary>
+	const bool isDone() const { return handle.promise().finished.load(std::memory_order_acquire); }
+
+	/// <summary>
+	/// Result of a started task once done, rethrowing anything it threw
+	/// </summary>
+	T get() { return handle.promise().result(); }
+
+private:
+	explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+	friend promise_type;
+
+private:
+	std::coroutine_handle<promise_type> handle;
+};
+
+template<typename T>
+Task<T> TaskPromise::Promise<T>::get_return_object() {
+	return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise::Promise<void>::get_return_object() {
+	return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
@@ -6,39 +6,192 @@
 #include "CommandPool.h"
 #include "Image.h"
 #include "Buffer.h"
+#include "TextureCooker.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    /// <summary>
+    /// Mapped staging memory the current thread's decode should put its final image in
+    /// </summary>
+    struct DecodeTarget {
+        void* memory = nullptr;
+        size_t size = 0;
+        bool inUse = false;
+    };
+    thread_local DecodeTarget decodeTarget;
+
+    // stb_image allocates its output in one go at exactly the final image's size, so the first allocation
+    // of that size is handed the staging memory and the decoder writes the pixels straight into it
+    void* decodeMalloc(size_t size) {
+        if (decodeTarget.memory && !decodeTarget.inUse && size == decodeTarget.size) {
+            decodeTarget.inUse = true;
+            return decodeTarget.memory;
+        }
+        return std::malloc(size);
+    }
+
+    void decodeFree(void* memory) {
+        if (memory && memory == decodeTarget.memory) {
+            decodeTarget.inUse = false;
+            return;
+        }
+        std::free(memory);
+    }
+
+    void* decodeRealloc(void* memory, size_t size) {
+        if (memory && memory == decodeTarget.memory) {
+            // staging memory can't grow, move it to the heap and free up the target for a later allocation
+            void* moved = std::malloc(size);
+            if (moved) std::memcpy(moved, memory, std::min(size, decodeTarget.size));
+            decodeTarget.inUse = false;
+            return moved;
+        }
+        return std::realloc(memory, size);
+    }
+
+    /// <summary>
+    /// Prefers cached staging memory, PNG unfiltering reads back the previous row which is very slow from write combined memory
+    /// </summary>
+    VkMemoryPropertyFlags getStagingMemoryProperties(const std::unique_ptr<PhysicalDevice>& physicalDevice) {
+        const VkMemoryPropertyFlags cachedProperties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice->getPhysicalDevice(), &memProperties);
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            if ((memProperties.memoryTypes[i].propertyFlags & cachedProperties) == cachedProperties) {
+                return cachedProperties;
+            }
+        }
+
+        return VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    }
+}
+
+#define STBI_MALLOC(size) decodeMalloc(size)
+#define STBI_REALLOC(memory, size) decodeRealloc(memory, size)
+#define STBI_FREE(memory) decodeFree(memory)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+namespace {
+    /// <summary>
+    /// Decodes an image straight into mapped staging memory, reading it from wherever the stb_image calls given read from
+    /// </summary>
+    /// <param name="info">Reads only the header, the size is needed to create the staging buffer before decoding</param>
+    /// <param name="load">Decodes the whole image to 8 bit RGBA</param>
+    template<typename Info, typename Load>
+    TextureImage decodeToStaging(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, Info info, Load load) {
+        TextureImage decodedImage;
+
+        int texWidth, texHeight, numChannels;
+        if (!info(&texWidth, &texHeight, &numChannels) || texWidth <= 0 || texHeight <= 0) {
+            return decodedImage;
+        }
+
+        const size_t size = static_cast<size_t>(texWidth) * texHeight * STBI_rgb_alpha;
+        auto stagingBuffer = std::make_unique<Buffer>(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, getStagingMemoryProperties(physicalDevice));
+
+        void* mapped;
+        stagingBuffer->mapMemory(&mapped);
+
+        // stb_image only shares its settings between loads, which are never changed, so decodes can run on many threads at once
+        decodeTarget = { mapped, size, false };
+        stbi_uc* pixels = load(&decodedImage.width, &decodedImage.height, &numChannels);
+
+        // the staging buffer was sized from the header, so only use the output if it decoded to exactly that many bytes
+        const size_t decodedSize = pixels ? static_cast<size_t>(decodedImage.width) * decodedImage.height * STBI_rgb_alpha : 0;
+        bool decoded = pixels && decodedSize == size && decodedImage.width == texWidth && decodedImage.height == texHeight;
+        if (pixels && !decoded) {
+            Debug::log("decoded image is " + std::to_string(decodedSize) + " bytes, expected " + std::to_string(size) + " from its header");
+        }
+        if (decoded && pixels != mapped) {
+            // the output was resized or converted after being allocated, copy the final image over
+            std::memcpy(mapped, pixels, size);
+        }
+        stbi_image_free(pixels);
+        decodeTarget = {};
+
+        stagingBuffer->unmapMemory();
+        if (decoded) {
+            decodedImage.stagingBuffer = std::move(stagingBuffer);
+        }
+        return decodedImage;
+    }
+}
+
 Texture::Texture(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const std::string path)
-    : device(device) {
-    // load image
-    int texWidth, texHeight, numChannels;
-    stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &numChannels, STBI_rgb_alpha);
-    VkDeviceSize size = texWidth * texHeight * 4;
-    mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
+    : Texture(device, physicalDevice, graphicsPool, transferPool, decode(path, device, physicalDevice)) { }
 
-    if (!pixels) {
+Texture::Texture(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const TextureImage& decodedImage)
+    : device(device) {
+    if (!decodedImage.stagingBuffer) {
         Debug::exception("failed to load texture image");
     }
 
-    // create a staging buffer with pixel data in
-    auto stagingBuffer = std::make_unique<Buffer>(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-
-    stagingBuffer->copyFromData(pixels);
-    stbi_image_free(pixels);
+    int texWidth = decodedImage.width, texHeight = decodedImage.height;
+    mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
     image = Image::createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, imageFormat, VK_IMAGE_TILING_OPTIMAL,
         VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, imageMemory, device, physicalDevice);
 
     Image::transitionImageLayout(image, imageFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, device, physicalDevice, transferPool);
-    stagingBuffer->copyToImage(transferPool, image, texWidth, texHeight);
-    generateMipmaps(graphicsPool, image, texWidth, texHeight, mipLevels); // does transition to read only whilst generating mipmaps
+    if (decodedImage.mipLevels == mipLevels) {
+        // cooked textures already have every level so only need copying
+        decodedImage.stagingBuffer->copyToImage(transferPool, image, texWidth, texHeight, mipLevels);
+        Image::transitionImageLayout(image, imageFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels, device, physicalDevice, transferPool, graphicsPool.get());
+    } else {
+        decodedImage.stagingBuffer->copyToImage(transferPool, image, texWidth, texHeight);
+        generateMipmaps(graphicsPool, image, texWidth, texHeight, mipLevels); // does transition to read only whilst generating mipmaps
+    }
 
     imageView = Image::createImageView(image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, device);
 }
 
+TextureImage Texture::decode(const std::string& path, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice) {
+    return decodeToStaging(device, physicalDevice,
+        [&](int* width, int* height, int* channels) { return stbi_info(path.c_str(), width, height, channels); },
+        [&](int* width, int* height, int* channels) { return stbi_load(path.c_str(), width, height, channels, STBI_rgb_alpha); });
+}
+
+TextureImage Texture::decode(const std::vector<char>& file, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice) {
+    const stbi_uc* data = reinterpret_cast<const stbi_uc*>(file.data());
+    const int size = static_cast<int>(file.size());
+    return decodeToStaging(device, physicalDevice,
+        [&](int* width, int* height, int* channels) { return stbi_info_from_memory(data, size, width, height, channels); },
+        [&](int* width, int* height, int* channels) { return stbi_load_from_memory(data, size, width, height, channels, STBI_rgb_alpha); });
+}
+
+TextureImage Texture::stageCooked(const std::vector<char>& file, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice) {
+    TextureImage stagedImage;
+
+    CookedTexture cooked;
+    if (!TextureCooker::parse(file, cooked)) {
+        return stagedImage;
+    }
+
+    stagedImage.width = static_cast<int>(cooked.width);
+    stagedImage.height = static_cast<int>(cooked.height);
+    stagedImage.mipLevels = cooked.mipLevels;
+    stagedImage.stagingBuffer = std::make_unique<Buffer>(device, physicalDevice, cooked.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    stagedImage.stagingBuffer->copyFromData(cooked.pixels);
+    return stagedImage;
+}
+
+TextureImage Texture::stage(const uint8_t* pixels, int width, int height, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice) {
+    TextureImage stagedImage;
+    stagedImage.width = width;
+    stagedImage.height = height;
+
+    VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 4;
+    stagedImage.stagingBuffer = std::make_unique<Buffer>(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    stagedImage.stagingBuffer->copyFromData(pixels);
+    return stagedImage;
+}
+
 Texture::~Texture() {
     vkDestroyImageView(device->getDevice(), imageView, nullptr); // must destroy image view before image
     vkDestroyImage(device->getDevice(), image, nullptr);
@@ -2,17 +2,63 @@
 #include <vulkan/vulkan.h>
 #include <memory>
 #include <string>
+#include <vector>
 #include <cmath>
 
 class PhysicalDevice;
 class LogicalDevice;
 class CommandPool;
+class Buffer;
+
+/// <summary>
+/// Image decoded to 8 bit RGBA pixels in a staging buffer, ready to be copied to the image
+/// </summary>
+struct TextureImage {
+	int width = 0;
+	int height = 0;
+
+	/// <summary>
+	/// Levels in the staging buffer tightly packed from the largest, the rest of the mip chain is generated on upload
+	/// </summary>
+	uint32_t mipLevels = 1;
+
+	/// <summary>
+	/// Null if the image failed to decode
+	/// </summary>
+	std::unique_ptr<Buffer> stagingBuffer;
+};
 
 class Texture {
 public:
 	Texture(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const std::string path);
+
+	/// <summary>
+	/// Uploads an already decoded image, see AssetLoader for decoding on worker threads
+	/// </summary>
+	Texture(const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice, const std::unique_ptr<CommandPool>& graphicsPool, const std::unique_ptr<CommandPool>& transferPool, const TextureImage& decodedImage);
 	~Texture();
 
+	/// <summary>
+	/// Decodes an image file straight into mapped staging memory. Only creates its own staging buffer
+	/// and doesn't record any commands so is safe to call from any thread
+	/// </summary>
+	static TextureImage decode(const std::string& path, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice);
+
+	/// <summary>
+	/// Decodes an image file already read into memory, see decode from a path
+	/// </summary>
+	static TextureImage decode(const std::vector<char>& file, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice);
+
+	/// <summary>
+	/// Copies a texture cooked by the AssetCooker, mip chain included, into a staging buffer, see TextureCooker
+	/// </summary>
+	static TextureImage stageCooked(const std::vector<char>& file, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice);
+
+	/// <summary>
+	/// Copies 8 bit RGBA pixels already in memory into a staging buffer, such as for generated textures
+	/// </summary>
+	static TextureImage stage(const uint8_t* pixels, int width, int height, const std::unique_ptr<LogicalDevice>& device, const std::unique_ptr<PhysicalDevice>& physicalDevice);
+
 	const uint32_t getMipLevels() const { return mipLevels; }
 	const VkImageView getImageView() const { return imageView; }
 
@@ -0,0 +1,147 @@
+#include "TextureCooker.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace TextureCooker {
+    namespace {
+        constexpr uint32_t TEXTURE_MAGIC = 0x58455456; // "VTEX"
+
+        /// <summary>
+        /// Increase whenever the file layout or the filtering that produces it changes
+        /// </summary>
+        constexpr uint32_t TEXTURE_VERSION = 1;
+
+        struct TextureHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t width;
+            uint32_t height;
+            uint32_t mipLevels;
+        };
+
+        /// <summary>
+        /// Bytes of all the levels together
+        /// </summary>
+        size_t getChainSize(uint32_t width, uint32_t height, uint32_t mipLevels) {
+            size_t size = 0;
+            for (uint32_t level = 0; level < mipLevels; level++) {
+                size += static_cast<size_t>(width) * height * 4;
+                width = std::max(width / 2, 1u);
+                height = std::max(height / 2, 1u);
+            }
+            return size;
+        }
+
+        float srgbToLinear(float value) {
+            return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+
+        uint8_t linearToSrgb(float value) {
+            value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+
+        const std::array<float, 256>& getLinearTable() {
+            static const std::array<float, 256> table = []() {
+                std::array<float, 256> values{};
+                for (size_t i = 0; i < values.size(); i++) {
+                    values[i] = srgbToLinear(i / 255.0f);
+                }
+                return values;
+            }();
+            return table;
+        }
+
+        /// <summary>
+        /// Box filters a level down to the next, odd edges repeat their last texel the same as a linear blit would clamp
+        /// </summary>
+        void downsample(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination) {
+            const auto& linear = getLinearTable();
+            const uint32_t nextWidth = std::max(width / 2, 1u);
+            const uint32_t nextHeight = std::max(height / 2, 1u);
+
+            for (uint32_t y = 0; y < nextHeight; y++) {
+                const uint32_t y0 = std::min(y * 2, height - 1);
+                const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+                for (uint32_t x = 0; x < nextWidth; x++) {
+                    const uint32_t x0 = std::min(x * 2, width - 1);
+                    const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+                    const std::array<const uint8_t*, 4> texels = {
+                        source + (static_cast<size_t>(y0) * width + x0) * 4,
+                        source + (static_cast<size_t>(y0) * width + x1) * 4,
+                        source + (static_cast<size_t>(y1) * width + x0) * 4,
+                        source + (static_cast<size_t>(y1) * width + x1) * 4
+                    };
+
+                    uint8_t* output = destination + (static_cast<size_t>(y) * nextWidth + x) * 4;
+                    for (uint32_t channel = 0; channel < 3; channel++) {
+                        float sum = 0.0f;
+                        for (const uint8_t* texel : texels) sum += linear[texel[channel]];
+                        output[channel] = linearToSrgb(sum * 0.25f);
+                    }
+
+                    // alpha is already linear
+                    uint32_t alpha = 0;
+                    for (const uint8_t* texel : texels) alpha += texel[3];
+                    output[3] = static_cast<uint8_t>((alpha + 2) / 4);
+                }
+            }
+        }
+    }
+
+    std::string getCookedPath(const std::string& sourcePath) {
+        return sourcePath + ".texture";
+    }
+
+    uint32_t getMipLevels(uint32_t width, uint32_t height) {
+        return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+    }
+
+    std::vector<char> cook(const uint8_t* pixels, uint32_t width, uint32_t height) {
+        TextureHeader header{};
+        header.magic = TEXTURE_MAGIC;
+        header.version = TEXTURE_VERSION;
+        header.width = width;
+        header.height = height;
+        header.mipLevels = getMipLevels(width, height);
+
+        std::vector<char> file(sizeof(TextureHeader) + getChainSize(width, height, header.mipLevels));
+        std::memcpy(file.data(), &header, sizeof(header));
+
+        uint8_t* level = reinterpret_cast<uint8_t*>(file.data() + sizeof(TextureHeader));
+        std::memcpy(level, pixels, static_cast<size_t>(width) * height * 4);
+
+        // each level is filtered from the one before, the same as the blits they replace
+        for (uint32_t i = 1; i < header.mipLevels; i++) {
+            uint8_t* nextLevel = level + static_cast<size_t>(width) * height * 4;
+            downsample(level, width, height, nextLevel);
+
+            level = nextLevel;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+
+        return file;
+    }
+
+    bool parse(const std::vector<char>& file, CookedTexture& texture) {
+        TextureHeader header;
+        if (file.size() < sizeof(header)) return false;
+        std::memcpy(&header, file.data(), sizeof(header));
+
+        if (header.magic != TEXTURE_MAGIC || header.version != TEXTURE_VERSION) return false;
+        if (header.width == 0 || header.height == 0 || header.mipLevels != getMipLevels(header.width, header.height)) return false;
+
+        const size_t size = getChainSize(header.width, header.height, header.mipLevels);
+        if (file.size() - sizeof(header) != size) return false;
+
+        texture.width = header.width;
+        texture.height = header.height;
+        texture.mipLevels = header.mipLevels;
+        texture.pixels = file.data() + sizeof(header);
+        texture.size = size;
+        return true;
+    }
+}
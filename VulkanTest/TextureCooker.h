@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Cooked texture file pointing into the file's memory, levels are tightly packed 8 bit RGBA from the largest down
+/// </summary>
+struct CookedTexture {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipLevels = 0;
+
+	const char* pixels = nullptr;
+	size_t size = 0;
+};
+
+/// <summary>
+/// Builds textures' full mip chains ahead of time so they are only copied to the image at runtime,
+/// shared by the AssetCooker and Texture
+/// </summary>
+namespace TextureCooker {
+	std::string getCookedPath(const std::string& sourcePath);
+
+	/// <summary>
+	/// Levels in a full mip chain down to 1x1, matching Texture
+	/// </summary>
+	uint32_t getMipLevels(uint32_t width, uint32_t height);
+
+	/// <summary>
+	/// Builds the mip chain of sRGB 8 bit RGBA pixels, filtering in linear space so levels don't darken
+	/// </summary>
+	/// <returns>The cooked file</returns>
+	std::vector<char> cook(const uint8_t* pixels, uint32_t width, uint32_t height);
+
+	/// <returns>False if the file is corrupt or was written by a different version</returns>
+	bool parse(const std::vector<char>& file, CookedTexture& texture);
+}
@@ -0,0 +1,141 @@
+#include "ThreadPool.h"
+#include <utility>
+
+namespace {
+    /// <summary>
+    /// Pool the current thread is a worker of and its index in it, so jobs queued from a worker go to its own deque
+    /// </summary>
+    thread_local ThreadPool* currentPool = nullptr;
+    thread_local uint32_t currentWorkerIndex = 0;
+}
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // every deque exists before any worker starts so they can steal from each other straight away
+    queues.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(std::function<void()> job, JobCounter& counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    enqueue([job = std::move(job), &counter]() {
+        try {
+            job();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(counter.exceptionMutex);
+            if (!counter.exception) counter.exception = std::current_exception();
+        }
+        counter.pending.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+void ThreadPool::wait(JobCounter& counter) {
+    while (!counter.isDone()) {
+        if (!tryRunJob()) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(counter.exceptionMutex);
+    if (counter.exception) {
+        std::rethrow_exception(std::exchange(counter.exception, nullptr));
+    }
+}
+
+void ThreadPool::runOnMainThread(std::function<void()> job) {
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    mainThreadJobs.push_back(std::move(job));
+}
+
+void ThreadPool::runMainThreadJobs() {
+    std::vector<std::function<void()>> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        jobs.swap(mainThreadJobs);
+    }
+
+    for (auto& job : jobs) {
+        job();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    // counted before being pushed so a thief taking it straight away never takes the count below zero
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t queueIndex = currentPool == this ? currentWorkerIndex : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->jobs.push_back(std::move(job));
+    }
+    jobAvailable.notify_one();
+}
+
+bool ThreadPool::tryRunJob() {
+    const bool isWorker = currentPool == this;
+    const uint32_t firstQueue = isWorker ? currentWorkerIndex : 0;
+
+    std::function<void()> job;
+    for (uint32_t i = 0; i < queues.size() && !job; i++) {
+        uint32_t queueIndex = static_cast<uint32_t>((firstQueue + i) % queues.size());
+        WorkerQueue& queue = *queues[queueIndex];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) continue;
+
+        // own jobs come off the back, stolen ones off the front so the thief takes the oldest and likely largest piece of work
+        if (isWorker && queueIndex == currentWorkerIndex) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        } else {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+    }
+
+    if (!job) return false;
+
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    job();
+    return true;
+}
+
+void ThreadPool::workerLoop(uint32_t workerIndex) {
+    currentPool = this;
+    currentWorkerIndex = workerIndex;
+
+    while (true) {
+        if (tryRunJob()) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        jobAvailable.wait(lock, [this]() { return stopping || queuedJobs.load(std::memory_order_relaxed) > 0; });
+
+        // only stop once every deque is drained so no submitted future is left without a result
+        if (stopping && queuedJobs.load(std::memory_order_relaxed) == 0) return;
+    }
+}
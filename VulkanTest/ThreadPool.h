@@ -0,0 +1,163 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Jobs in a group still to finish, wait on it with ThreadPool::wait to join them
+/// </summary>
+struct JobCounter {
+	std::atomic<uint32_t> pending = 0;
+
+	/// <summary>
+	/// First exception thrown by one of the jobs, rethrown by ThreadPool::wait
+	/// </summary>
+	std::mutex exceptionMutex;
+	std::exception_ptr exception;
+
+	const bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+/// <summary>
+/// Work stealing job system. Each worker has its own deque, taking its newest job first so related work stays
+/// in cache, and steals the oldest job from another worker when its own runs dry. Jobs that must run on the
+/// main thread, such as GLFW calls and queue submissions, are held until the main thread runs them
+/// </summary>
+class ThreadPool {
+public:
+	/// <param name="threadCount">Worker threads to start, 0 for one per hardware thread</param>
+	ThreadPool(uint32_t threadCount = 0);
+
+	/// <summary>
+	/// Finishes all queued jobs then joins the workers, main thread jobs are dropped
+	/// </summary>
+	~ThreadPool();
+
+	/// <summary>
+	/// Queues a task to run on a worker
+	/// </summary>
+	/// <returns>Future holding the task's result or any exception it threw</returns>
+	template<typename Task>
+	std::future<std::invoke_result_t<Task>> submit(Task&& task) {
+		auto packagedTask = std::make_shared<std::packaged_task<std::invoke_result_t<Task>()>>(std::forward<Task>(task));
+		auto future = packagedTask->get_future();
+		enqueue([packagedTask]() { (*packagedTask)(); });
+		return future;
+	}
+
+	/// <summary>
+	/// Queues a job counted by the counter, which stays above zero until the job has finished
+	/// </summary>
+	void run(std::function<void()> job, JobCounter& counter);
+
+	/// <summary>
+	/// Runs queued jobs on the calling thread until the counter reaches zero, so waiting from a job never deadlocks
+	/// </summary>
+	/// <exception>Rethrows the first exception thrown by the counted jobs</exception>
+	void wait(JobCounter& counter);
+
+	/// <summary>
+	/// Calls body for every index from 0 to count, split into jobs of batchSize indices, and waits for them all
+	/// </summary>
+	template<typename Body>
+	void parallelFor(uint32_t count, uint32_t batchSize, const Body& body) {
+		JobCounter counter;
+		for (uint32_t begin = 0; begin < count; begin += batchSize) {
+			uint32_t end = std::min(count, begin + batchSize);
+			run([&body, begin, end]() {
+				for (uint32_t i = begin; i < end; i++) {
+					body(i);
+				}
+			}, counter);
+		}
+		wait(counter);
+	}
+
+	/// <summary>
+	/// Awaiting the result suspends the coroutine and resumes it on a worker
+	/// </summary>
+	auto schedule() {
+		struct ScheduleAwaiter {
+			ThreadPool& threadPool;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) { threadPool.enqueue([handle]() { handle.resume(); }); }
+			void await_resume() const noexcept {}
+		};
+		return ScheduleAwaiter{ *this };
+	}
+
+	/// <summary>
+	/// Queues a job for the next runMainThreadJobs
+	/// </summary>
+	void runOnMainThread(std::function<void()> job);
+
+	/// <summary>
+	/// Awaiting the result suspends the coroutine until the next runMainThreadJobs resumes it
+	/// </summary>
+	auto scheduleOnMainThread() {
+		struct MainThreadAwaiter {
+			ThreadPool& threadPool;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) { threadPool.runOnMainThread([handle]() { handle.resume(); }); }
+			void await_resume() const noexcept {}
+		};
+		return MainThreadAwaiter{ *this };
+	}
+
+	/// <summary>
+	/// Runs the main thread jobs queued so far, only call from the main thread. Jobs queued while running are left for the next call
+	/// </summary>
+	void runMainThreadJobs();
+
+	const uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+private:
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+
+	/// <summary>
+	/// Pushes onto the calling worker's own deque, or spreads jobs from other threads across the workers
+	/// </summary>
+	void enqueue(std::function<void()> job);
+
+	/// <summary>
+	/// Runs one job, the newest from the calling worker's deque or else the oldest stolen from another
+	/// </summary>
+	/// <returns>False if every deque was empty</returns>
+	bool tryRunJob();
+
+	void workerLoop(uint32_t workerIndex);
+
+private:
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+	/// <summary>
+	/// Worker the next job from outside the pool is pushed to
+	/// </summary>
+	std::atomic<uint32_t> nextQueue = 0;
+
+	/// <summary>
+	/// Jobs in all of the deques, workers sleep while it's zero. Only increased under sleepMutex so a wake up is never missed
+	/// </summary>
+	std::atomic<uint32_t> queuedJobs = 0;
+	std::mutex sleepMutex;
+	std::condition_variable jobAvailable;
+	bool stopping = false;
+
+	std::mutex mainThreadMutex;
+	std::vector<std::function<void()>> mainThreadJobs;
+};
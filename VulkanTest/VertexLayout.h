@@ -0,0 +1,136 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "ContentHash.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// Attribute types stored in fewer bytes than floats, the input assembler widens them back to floats for the shader
+/// </summary>
+namespace PackedVertex {
+	struct Unorm8x4 { uint8_t x, y, z, w; };	// colours
+	struct Snorm8x4 { int8_t x, y, z, w; };		// normals and tangents
+	struct Unorm16x2 { uint16_t x, y; };		// texture coordinates in [0, 1]
+	struct Snorm16x2 { int16_t x, y; };			// octahedral encoded normals
+	struct Half2 { uint16_t x, y; };			// texture coordinates that wrap
+	struct Half4 { uint16_t x, y, z, w; };
+}
+
+/// <summary>
+/// The VkFormat a field's type is read with. Matrices take a location per column, so a mat4 is read as four vec4s
+/// </summary>
+template<typename T>
+struct VertexFormat {
+	static_assert(sizeof(T) == 0, "no VkFormat for this vertex field type, add a VertexFormat specialisation");
+};
+
+#define VERTEX_FORMAT(type, vkFormat, columns) \
+	template<> struct VertexFormat<type> { \
+		static constexpr VkFormat format = vkFormat; \
+		static constexpr uint32_t locationCount = columns; \
+	};
+
+VERTEX_FORMAT(float, VK_FORMAT_R32_SFLOAT, 1)
+VERTEX_FORMAT(glm::vec2, VK_FORMAT_R32G32_SFLOAT, 1)
+VERTEX_FORMAT(glm::vec3, VK_FORMAT_R32G32B32_SFLOAT, 1)
+VERTEX_FORMAT(glm::vec4, VK_FORMAT_R32G32B32A32_SFLOAT, 1)
+VERTEX_FORMAT(int32_t, VK_FORMAT_R32_SINT, 1)
+VERTEX_FORMAT(glm::ivec2, VK_FORMAT_R32G32_SINT, 1)
+VERTEX_FORMAT(glm::ivec3, VK_FORMAT_R32G32B32_SINT, 1)
+VERTEX_FORMAT(glm::ivec4, VK_FORMAT_R32G32B32A32_SINT, 1)
+VERTEX_FORMAT(uint32_t, VK_FORMAT_R32_UINT, 1)
+VERTEX_FORMAT(glm::uvec2, VK_FORMAT_R32G32_UINT, 1)
+VERTEX_FORMAT(glm::uvec3, VK_FORMAT_R32G32B32_UINT, 1)
+VERTEX_FORMAT(glm::uvec4, VK_FORMAT_R32G32B32A32_UINT, 1)
+VERTEX_FORMAT(glm::mat3, VK_FORMAT_R32G32B32_SFLOAT, 3)
+VERTEX_FORMAT(glm::mat4, VK_FORMAT_R32G32B32A32_SFLOAT, 4)
+VERTEX_FORMAT(PackedVertex::Unorm8x4, VK_FORMAT_R8G8B8A8_UNORM, 1)
+VERTEX_FORMAT(PackedVertex::Snorm8x4, VK_FORMAT_R8G8B8A8_SNORM, 1)
+VERTEX_FORMAT(PackedVertex::Unorm16x2, VK_FORMAT_R16G16_UNORM, 1)
+VERTEX_FORMAT(PackedVertex::Snorm16x2, VK_FORMAT_R16G16_SNORM, 1)
+VERTEX_FORMAT(PackedVertex::Half2, VK_FORMAT_R16G16_SFLOAT, 1)
+VERTEX_FORMAT(PackedVertex::Half4, VK_FORMAT_R16G16B16A16_SFLOAT, 1)
+
+#undef VERTEX_FORMAT
+
+/// <summary>
+/// One field of a vertex struct, make with VERTEX_FIELD
+/// </summary>
+struct VertexField {
+	uint32_t offset;
+	VkFormat format;
+	uint32_t locationCount;
+	uint32_t size;
+};
+
+/// <summary>
+/// Describes a member for a vertex struct's static constexpr getFields(), its format follows from the member's type
+/// </summary>
+#define VERTEX_FIELD(vertex, member) \
+	VertexField{ static_cast<uint32_t>(offsetof(vertex, member)), VertexFormat<decltype(vertex::member)>::format, \
+		VertexFormat<decltype(vertex::member)>::locationCount, static_cast<uint32_t>(sizeof(vertex::member)) }
+
+/// <summary>
+/// Vulkan's vertex input descriptions for a vertex struct, derived at compile time from the fields its getFields() lists.
+/// Each field takes the next shader location in the order they're listed
+/// </summary>
+template<typename T>
+class VertexLayout {
+public:
+	static constexpr auto FIELDS = T::getFields();
+
+	static constexpr uint32_t LOCATION_COUNT = [] {
+		uint32_t count = 0;
+		for (const VertexField& field : FIELDS) count += field.locationCount;
+		return count;
+	}();
+
+	/// <summary>
+	/// Hash of the stride, formats and offsets, so pipelines reading equal layouts hash equally, see PipelineKey
+	/// </summary>
+	static constexpr uint64_t HASH = [] {
+		uint64_t hash = ContentHash::hashValue(static_cast<uint32_t>(sizeof(T)));
+		for (const VertexField& field : FIELDS) {
+			hash = ContentHash::hashValue(field.offset, hash);
+			hash = ContentHash::hashValue(static_cast<uint32_t>(field.format), hash);
+			hash = ContentHash::hashValue(field.locationCount, hash);
+		}
+		return hash;
+	}();
+
+	static constexpr VkVertexInputBindingDescription getBindingDescription(uint32_t binding, VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX) {
+		return { binding, static_cast<uint32_t>(sizeof(T)), inputRate };
+	}
+
+	/// <param name="firstLocation">Shader location of the first field, so layouts of several bindings can follow each other</param>
+	static constexpr std::array<VkVertexInputAttributeDescription, LOCATION_COUNT> getAttributeDescriptions(uint32_t binding, uint32_t firstLocation = 0) {
+		std::array<VkVertexInputAttributeDescription, LOCATION_COUNT> attributeDescs{};
+
+		uint32_t location = 0;
+		for (const VertexField& field : FIELDS) {
+			// matrix columns are read one after another
+			const uint32_t columnSize = field.size / field.locationCount;
+			for (uint32_t column = 0; column < field.locationCount; column++) {
+				attributeDescs[location] = { firstLocation + location, binding, field.format, field.offset + column * columnSize };
+				location++;
+			}
+		}
+
+		return attributeDescs;
+	}
+
+private:
+	static constexpr bool FIELDS_FIT = [] {
+		for (const VertexField& field : FIELDS) {
+			if (field.offset + field.size > sizeof(T)) return false;
+		}
+		return true;
+	}();
+	static_assert(FIELDS_FIT, "vertex field lies outside the vertex");
+};
@@ -7,6 +7,20 @@ layout(location = 1) in vec2 fragTexCoord;
 
 layout(location = 0) out vec4 outColor;
 
+// material variants, specialised when the pipeline compiles so the unused paths are removed rather than branched over
+layout(constant_id = 0) const bool USE_TEXTURE = true;
+layout(constant_id = 1) const bool USE_VERTEX_COLOR = true;
+layout(constant_id = 2) const bool ALPHA_TEST = false;
+layout(constant_id = 3) const float ALPHA_CUTOFF = 0.5;
+
 void main() {
-    outColor = vec4(texture(texSampler, fragTexCoord).rgb * fragColor, 1.0);
+    vec4 color = USE_TEXTURE ? texture(texSampler, fragTexCoord) : vec4(1.0);
+    if (USE_VERTEX_COLOR) {
+        color.rgb *= fragColor;
+    }
+    if (ALPHA_TEST && color.a < ALPHA_CUTOFF) {
+        discard;
+    }
+
+    outColor = vec4(color.rgb, 1.0);
 }
\ No newline at end of file
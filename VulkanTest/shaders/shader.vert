@@ -10,11 +10,15 @@ layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
+// per instance, from the second binding, the matrix taking locations 3 to 6
+layout(location = 3) in mat4 inInstanceModel;
+layout(location = 7) in vec4 inInstanceColor;
+
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
-	fragColor = inColor;
+	gl_Position = ubo.proj * ubo.view * ubo.model * inInstanceModel * vec4(inPosition, 1.0);
+	fragColor = inColor * inInstanceColor.rgb;
 	fragTexCoord = inTexCoord;
 }
\ No newline at end of file